@@ -0,0 +1,70 @@
+//-----------------------------------------------------------------------------
+// benchCommon.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_BENCHCOMMON_HPP_
+#define _JBL_BENCHCOMMON_HPP_
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "jbl/types.hpp"
+
+/// Gets a monotonic time stamp for timing benchmarks.
+/// @return The current time in seconds from an unspecified starting point.
+inline F64 getBenchTime()
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	LARGE_INTEGER counter;
+	QueryPerformanceFrequency(&frequency);
+	QueryPerformanceCounter(&counter);
+	return static_cast<F64>(counter.QuadPart) / static_cast<F64>(frequency.QuadPart);
+#else
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<F64>(now.tv_sec) + static_cast<F64>(now.tv_nsec) * 1.0e-9;
+#endif
+}
+
+/// A small xorshift generator, so that generating keys costs next to nothing
+/// compared to the work that is being measured.
+struct BenchRandom
+{
+	U32 state;
+
+	explicit BenchRandom(U32 seed) : state(seed != 0 ? seed : 1) {}
+
+	U32 next()
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state;
+	}
+};
+
+#endif // _JBL_BENCHCOMMON_HPP_
@@ -0,0 +1,133 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+// Measures how lookups and updates scale with the amount of threads, for a
+// ConcurrentDictionary against a Dictionary behind a single Mutex.
+// Every operation is a lookup, with one out of every eight being an update.
+// Configure with -DBuildJBLBenchmarks=ON -DCMAKE_BUILD_TYPE=Release, the
+// numbers of an unoptimized build say very little.
+
+#include <stdio.h>
+#include "jbl/thread.hpp"
+#include "jbl/mutex.hpp"
+#include "jbl/dictionary.hpp"
+#include "jbl/concurrentDictionary.hpp"
+#include "benchmarks/benchCommon.hpp"
+
+static const S32 sKeyCount = 1 << 16;
+static const S32 sOpsPerThread = 200000;
+static const S32 sMaxThreads = 64;
+
+ConcurrentDictionary<S32, S32> sharded(256);
+
+Mutex globalMutex;
+Dictionary<S32, S32> global;
+
+struct WorkerData
+{
+	U32 seed;
+	S32 hits;
+};
+
+void shardedWorker(void *arg)
+{
+	WorkerData *data = static_cast<WorkerData*>(arg);
+	BenchRandom random(data->seed);
+	for (S32 i = 0; i < sOpsPerThread; ++i)
+	{
+		const U32 bits = random.next();
+		const S32 key = static_cast<S32>(bits % sKeyCount);
+		if ((bits >> 29) == 0)
+		{
+			sharded.insertOrAssign(key, i);
+		}
+		else
+		{
+			S32 value;
+			if (sharded.find(key, value))
+				++data->hits;
+		}
+	}
+}
+
+void globalWorker(void *arg)
+{
+	WorkerData *data = static_cast<WorkerData*>(arg);
+	BenchRandom random(data->seed);
+	for (S32 i = 0; i < sOpsPerThread; ++i)
+	{
+		const U32 bits = random.next();
+		const S32 key = static_cast<S32>(bits % sKeyCount);
+		LockGuard guard(&globalMutex);
+		if ((bits >> 29) == 0)
+		{
+			global.insertOrAssign(key, i);
+		}
+		else if (global.contains(key))
+		{
+			++data->hits;
+		}
+	}
+}
+
+/// Runs fn on threadCount threads at once.
+/// @return The amount of operations per second over all threads.
+F64 run(threadFunction fn, S32 threadCount)
+{
+	WorkerData data[sMaxThreads];
+	Thread *threads[sMaxThreads];
+
+	const F64 start = getBenchTime();
+	for (S32 i = 0; i < threadCount; ++i)
+	{
+		data[i].seed = static_cast<U32>(i + 1) * 2654435761U;
+		data[i].hits = 0;
+		threads[i] = new Thread(fn, &data[i]);
+	}
+	for (S32 i = 0; i < threadCount; ++i)
+	{
+		threads[i]->join();
+		delete threads[i];
+	}
+	const F64 elapsed = getBenchTime() - start;
+
+	return static_cast<F64>(threadCount) * static_cast<F64>(sOpsPerThread) / elapsed;
+}
+
+S32 main(S32 argc, const char **argv)
+{
+	for (S32 i = 0; i < sKeyCount; i += 2)
+	{
+		sharded.insert(i, i);
+		global.insert(i, i);
+	}
+
+	printf("%8s %16s %16s %8s\n", "threads", "global Mops/s", "sharded Mops/s", "speedup");
+	for (S32 threadCount = 1; threadCount <= sMaxThreads; threadCount *= 2)
+	{
+		const F64 globalOps = run(globalWorker, threadCount);
+		const F64 shardedOps = run(shardedWorker, threadCount);
+		printf("%8d %16.2f %16.2f %7.2fx\n", threadCount, globalOps * 1.0e-6, shardedOps * 1.0e-6, shardedOps / globalOps);
+	}
+
+	return 0;
+}
@@ -0,0 +1,73 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+// Compares building a Dictionary one insert at a time against
+// buildParallel with a growing amount of threads. Pass the amount of pairs
+// as the first argument. Configure with -DBuildJBLBenchmarks=ON
+// -DCMAKE_BUILD_TYPE=Release, the numbers of an unoptimized build say very
+// little.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "jbl/vector.hpp"
+#include "jbl/dictionary.hpp"
+#include "benchmarks/benchCommon.hpp"
+
+typedef Dictionary<U32, U32> BenchDictionary;
+
+S32 main(S32 argc, const char **argv)
+{
+	const S32 size = argc > 1 ? atoi(argv[1]) : 4000000;
+
+	Vector<BenchDictionary::KVPair> pairs(size);
+	BenchRandom random(12345);
+	for (S32 i = 0; i < size; ++i)
+		pairs.add(BenchDictionary::KVPair(random.next(), static_cast<U32>(i)));
+
+	F64 start = getBenchTime();
+	{
+		BenchDictionary dictionary;
+		for (S32 i = 0; i < size; ++i)
+			dictionary.insert(pairs[i].key, pairs[i].value);
+	}
+	const F64 insertMs = (getBenchTime() - start) * 1.0e3;
+	printf("%d pairs\n", size);
+	printf(" %-22s %10.2f ms\n", "insert one by one", insertMs);
+
+	const S32 threadCounts[] = { 1, 2, 4, 8, 16 };
+	for (S32 threads : threadCounts)
+	{
+		start = getBenchTime();
+		{
+			BenchDictionary dictionary;
+			dictionary.buildParallel(pairs, threads);
+		}
+		const F64 buildMs = (getBenchTime() - start) * 1.0e3;
+
+		char label[32];
+		snprintf(label, sizeof(label), "buildParallel, %d", threads);
+		printf(" %-22s %10.2f ms %6.2fx\n", label, buildMs, insertMs / buildMs);
+	}
+
+	return 0;
+}
@@ -0,0 +1,108 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+// Compares the startup time of rebuilding a Dictionary<String, S32> one key
+// at a time against opening a DictionarySnapshot of it, and the lookup
+// speed of both afterwards. Pass the amount of keys as the first argument.
+// Configure with -DBuildJBLBenchmarks=ON -DCMAKE_BUILD_TYPE=Release, the
+// numbers of an unoptimized build say very little.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "jbl/string.hpp"
+#include "jbl/dictionary.hpp"
+#include "jbl/dictionarySnapshot.hpp"
+#include "benchmarks/benchCommon.hpp"
+
+static const char *sPath = "benchDictionarySnapshot.bin";
+static const S32 sLookups = 4000000;
+
+S32 main(S32 argc, const char **argv)
+{
+	const S32 size = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	String *keys = new String[size];
+	for (S32 i = 0; i < size; ++i)
+	{
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), "tenant-%d.example.com/route", i);
+		keys[i] = buffer;
+	}
+
+	F64 start = getBenchTime();
+	Dictionary<String, S32> *rebuilt = new Dictionary<String, S32>();
+	for (S32 i = 0; i < size; ++i)
+		rebuilt->insert(keys[i], i);
+	const F64 rebuildMs = (getBenchTime() - start) * 1.0e3;
+
+	start = getBenchTime();
+	if (!DictionarySnapshot<S32>::write(*rebuilt, sPath))
+	{
+		printf("Could not write %s.\n", sPath);
+		return 1;
+	}
+	const F64 writeMs = (getBenchTime() - start) * 1.0e3;
+
+	DictionarySnapshot<S32> snapshot;
+	start = getBenchTime();
+	snapshot.open(sPath, true);
+	const F64 openCheckedMs = (getBenchTime() - start) * 1.0e3;
+
+	start = getBenchTime();
+	snapshot.open(sPath, false);
+	const F64 openMs = (getBenchTime() - start) * 1.0e3;
+
+	printf("%d keys\n", size);
+	printf(" rebuild by inserting:      %10.2f ms\n", rebuildMs);
+	printf(" write snapshot:            %10.2f ms\n", writeMs);
+	printf(" open snapshot, checksummed:%10.2f ms\n", openCheckedMs);
+	printf(" open snapshot, trusted:    %10.2f ms\n", openMs);
+
+	// The keys to look up are picked before the clock starts.
+	const S32 pickCount = 4096;
+	S32 picks[pickCount];
+	BenchRandom random(12345);
+	for (S32 i = 0; i < pickCount; ++i)
+		picks[i] = static_cast<S32>(random.next() % static_cast<U32>(size));
+
+	S32 hits = 0;
+	start = getBenchTime();
+	for (S32 i = 0; i < sLookups; ++i)
+		hits += rebuilt->contains(keys[picks[i & (pickCount - 1)]]) ? 1 : 0;
+	const F64 dictionaryNs = (getBenchTime() - start) * 1.0e9 / sLookups;
+
+	start = getBenchTime();
+	for (S32 i = 0; i < sLookups; ++i)
+		hits += snapshot.contains(keys[picks[i & (pickCount - 1)]]) ? 1 : 0;
+	const F64 snapshotNs = (getBenchTime() - start) * 1.0e9 / sLookups;
+
+	printf(" lookup in Dictionary:      %10.2f ns\n", dictionaryNs);
+	printf(" lookup in snapshot:        %10.2f ns\n", snapshotNs);
+	printf(" (%d hits)\n", hits);
+
+	snapshot.close();
+	remove(sPath);
+	delete rebuilt;
+	delete[] keys;
+	return 0;
+}
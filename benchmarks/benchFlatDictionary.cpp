@@ -0,0 +1,125 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+// Compares lookups into a FlatDictionary against a Dictionary for a range of
+// sizes, with integer keys and with String keys. Half of the lookups miss.
+// Configure with -DBuildJBLBenchmarks=ON -DCMAKE_BUILD_TYPE=Release, the
+// numbers of an unoptimized build say very little.
+
+#include <stdio.h>
+#include "jbl/string.hpp"
+#include "jbl/vector.hpp"
+#include "jbl/dictionary.hpp"
+#include "jbl/flatDictionary.hpp"
+#include "benchmarks/benchCommon.hpp"
+
+static const S32 sLookups = 4000000;
+
+// The keys to look up are picked before the clock starts, so that picking
+// them is not part of what is measured.
+static const S32 sPickCount = 4096;
+static S32 sPicks[sPickCount];
+
+template<typename Map, typename Key>
+F64 timeLookups(const Map &map, const Key *keys, S32 keyCount, S32 &hits)
+{
+	BenchRandom random(12345);
+	for (S32 i = 0; i < sPickCount; ++i)
+		sPicks[i] = static_cast<S32>(random.next() % static_cast<U32>(keyCount));
+
+	const F64 start = getBenchTime();
+	for (S32 i = 0; i < sLookups; ++i)
+	{
+		if (map.contains(keys[sPicks[i & (sPickCount - 1)]]))
+			++hits;
+	}
+	return (getBenchTime() - start) * 1.0e9 / sLookups;
+}
+
+void benchIntegers(S32 size)
+{
+	Vector<FlatDictionary<S32, S32>::KVPair> pairs(size);
+	Dictionary<S32, S32> hashed;
+	S32 *keys = new S32[size * 2];
+	for (S32 i = 0; i < size; ++i)
+	{
+		FlatDictionary<S32, S32>::KVPair pair;
+		pair.key = i * 2;
+		pair.value = i;
+		pairs.add(pair);
+		hashed.insert(pair.key, pair.value);
+
+		keys[i * 2] = i * 2;
+		keys[i * 2 + 1] = i * 2 + 1;
+	}
+
+	FlatDictionary<S32, S32> flat;
+	flat.build(pairs);
+
+	S32 hits = 0;
+	const F64 flatNs = timeLookups(flat, keys, size * 2, hits);
+	const F64 hashedNs = timeLookups(hashed, keys, size * 2, hits);
+	printf("%8s %6d %12.2f %12.2f %8.2fx\n", "S32", size, flatNs, hashedNs, hashedNs / flatNs);
+
+	delete[] keys;
+}
+
+void benchStrings(S32 size)
+{
+	Vector<FlatDictionary<String, S32>::KVPair> pairs(size);
+	Dictionary<String, S32> hashed;
+	String *keys = new String[size * 2];
+	for (S32 i = 0; i < size; ++i)
+	{
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), "tenant-%d.example.com/route", i * 2);
+		keys[i * 2] = buffer;
+		snprintf(buffer, sizeof(buffer), "tenant-%d.example.com/route", i * 2 + 1);
+		keys[i * 2 + 1] = buffer;
+
+		hashed.insert(keys[i * 2], i);
+	}
+
+	FlatDictionary<String, S32> flat;
+	for (S32 i = 0; i < size; ++i)
+		flat.insert(keys[i * 2], i);
+
+	S32 hits = 0;
+	const F64 flatNs = timeLookups(flat, keys, size * 2, hits);
+	const F64 hashedNs = timeLookups(hashed, keys, size * 2, hits);
+	printf("%8s %6d %12.2f %12.2f %8.2fx\n", "String", size, flatNs, hashedNs, hashedNs / flatNs);
+
+	delete[] keys;
+}
+
+S32 main(S32 argc, const char **argv)
+{
+	const S32 sizes[] = { 4, 8, 16, 32, 64, 128, 256, 1024, 4096, 65536 };
+
+	printf("%8s %6s %12s %12s %9s\n", "keys", "size", "flat ns", "hashed ns", "speedup");
+	for (S32 size : sizes)
+		benchIntegers(size);
+	for (S32 size : sizes)
+		benchStrings(size);
+
+	return 0;
+}
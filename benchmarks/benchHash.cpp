@@ -0,0 +1,85 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+// Measures the throughput of hashBytes against a byte at a time 32 bit
+// FNV-1a, for keys from a few bytes up to a few kilobytes.
+// Configure with -DBuildJBLBenchmarks=ON -DCMAKE_BUILD_TYPE=Release, the
+// numbers of an unoptimized build say very little.
+
+#include <stdio.h>
+#include <string.h>
+#include "jbl/hash.hpp"
+#include "benchmarks/benchCommon.hpp"
+
+static const size_t sTotalBytes = 256 * 1024 * 1024;
+
+static U32 fnv1a(const void *data, size_t length)
+{
+	const U8 *bytes = static_cast<const U8*>(data);
+	U32 hash = 2166136261U;
+	for (size_t i = 0; i < length; ++i)
+		hash = (hash ^ bytes[i]) * 16777619U;
+	return hash;
+}
+
+S32 main(S32 argc, const char **argv)
+{
+	static U8 buffer[4096];
+	BenchRandom random(12345);
+	for (size_t i = 0; i < sizeof(buffer); ++i)
+		buffer[i] = static_cast<U8>(random.next());
+
+	const size_t lengths[] = { 4, 8, 16, 24, 32, 64, 128, 256, 1024, 4096 };
+
+	printf("%8s %12s %12s %12s %12s\n", "bytes", "fnv ns", "hash ns", "fnv GB/s", "hash GB/s");
+	U64 sink = 0;
+	for (size_t length : lengths)
+	{
+		const size_t iterations = sTotalBytes / length;
+
+		// Every hash feeds into the next key, so that calls cannot overlap
+		// and the numbers are latencies.
+		F64 start = getBenchTime();
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			buffer[0] = static_cast<U8>(sink);
+			sink += fnv1a(buffer, length);
+		}
+		const F64 fnvSeconds = getBenchTime() - start;
+
+		start = getBenchTime();
+		for (size_t i = 0; i < iterations; ++i)
+		{
+			buffer[0] = static_cast<U8>(sink);
+			sink += hashBytes(buffer, length);
+		}
+		const F64 hashSeconds = getBenchTime() - start;
+
+		printf("%8d %12.2f %12.2f %12.2f %12.2f\n", static_cast<S32>(length),
+			fnvSeconds * 1.0e9 / iterations, hashSeconds * 1.0e9 / iterations,
+			sTotalBytes / fnvSeconds * 1.0e-9, sTotalBytes / hashSeconds * 1.0e-9);
+	}
+
+	// Keeps the hashes from being optimized away.
+	return sink == 0x123456789ULL ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+//-----------------------------------------------------------------------------
+// atomic.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_ATOMIC_HPP_
+#define _JBL_ATOMIC_HPP_
+
+#include <string.h>
+#include "compiler.hpp"
+#include "types.hpp"
+
+/// How much ordering an atomic operation gives relative to the memory
+/// operations around it.
+enum MemoryOrder
+{
+	/// Only the operation itself is atomic.
+	eMemoryOrderRelaxed,
+
+	/// Loads: nothing after the load can be moved before it.
+	eMemoryOrderAcquire,
+
+	/// Stores: nothing before the store can be moved after it.
+	eMemoryOrderRelease,
+
+	/// Acquire and release, and all threads agree on one order of every
+	/// sequentially consistent operation.
+	eMemoryOrderSeqCst
+};
+
+#ifdef _MSC_VER
+namespace AtomicDetail
+{
+	/// The Interlocked functions that fit an atomic of Size bytes.
+	template<size_t Size> struct Ops;
+
+	template<> struct Ops<4>
+	{
+		typedef long Bits;
+		static FORCE_INLINE Bits exchange(volatile Bits *address, Bits value) { return _InterlockedExchange(address, value); }
+		static FORCE_INLINE Bits fetchAdd(volatile Bits *address, Bits value) { return _InterlockedExchangeAdd(address, value); }
+		static FORCE_INLINE Bits compareExchange(volatile Bits *address, Bits desired, Bits expected) { return _InterlockedCompareExchange(address, desired, expected); }
+	};
+
+	template<> struct Ops<8>
+	{
+		typedef __int64 Bits;
+		static FORCE_INLINE Bits exchange(volatile Bits *address, Bits value) { return _InterlockedExchange64(address, value); }
+		static FORCE_INLINE Bits fetchAdd(volatile Bits *address, Bits value) { return _InterlockedExchangeAdd64(address, value); }
+		static FORCE_INLINE Bits compareExchange(volatile Bits *address, Bits desired, Bits expected) { return _InterlockedCompareExchange64(address, desired, expected); }
+	};
+
+	template<typename To, typename From>
+	FORCE_INLINE To bitCast(const From &from)
+	{
+		static_assert(sizeof(To) == sizeof(From), "bitCast needs types of the same size.");
+		To to;
+		memcpy(&to, &from, sizeof(To));
+		return to;
+	}
+}
+#endif
+
+/// A value that can be read and written by many threads at once.
+///
+/// T has to be an integer or a pointer of 4 or 8 bytes. This is a thin
+/// wrapper over the __atomic builtins of GCC and Clang and the Interlocked
+/// functions of MSVC.
+template<typename T>
+class Atomic
+{
+public:
+	Atomic() : mValue() {}
+	explicit Atomic(T value) : mValue(value) {}
+
+	Atomic(const Atomic &) = delete;
+	Atomic& operator=(const Atomic &) = delete;
+
+	/// Reads the value.
+	/// @param order eMemoryOrderRelaxed, eMemoryOrderAcquire or eMemoryOrderSeqCst.
+	FORCE_INLINE T load(MemoryOrder order = eMemoryOrderSeqCst) const
+	{
+#ifdef _MSC_VER
+		// Plain loads on x86 already have acquire semantics, the barrier
+		// only stops the compiler from moving things around.
+		T value = *const_cast<const volatile T*>(&mValue);
+		_ReadWriteBarrier();
+		return value;
+#else
+		return __atomic_load_n(&mValue, toBuiltinOrder(order));
+#endif
+	}
+
+	/// Writes the value.
+	/// @param order eMemoryOrderRelaxed, eMemoryOrderRelease or eMemoryOrderSeqCst.
+	FORCE_INLINE void store(T value, MemoryOrder order = eMemoryOrderSeqCst)
+	{
+#ifdef _MSC_VER
+		if (order == eMemoryOrderSeqCst)
+		{
+			exchange(value);
+			return;
+		}
+		_ReadWriteBarrier();
+		*const_cast<volatile T*>(&mValue) = value;
+#else
+		__atomic_store_n(&mValue, value, toBuiltinOrder(order));
+#endif
+	}
+
+	/// Writes the value and returns the value that was there before.
+	FORCE_INLINE T exchange(T value)
+	{
+#ifdef _MSC_VER
+		typedef AtomicDetail::Ops<sizeof(T)> Ops;
+		return AtomicDetail::bitCast<T>(Ops::exchange(bits(), AtomicDetail::bitCast<typename Ops::Bits>(value)));
+#else
+		return __atomic_exchange_n(&mValue, value, __ATOMIC_SEQ_CST);
+#endif
+	}
+
+	/// Adds to an integer value.
+	/// @return The value before the addition.
+	FORCE_INLINE T fetchAdd(T value)
+	{
+#ifdef _MSC_VER
+		typedef AtomicDetail::Ops<sizeof(T)> Ops;
+		return static_cast<T>(Ops::fetchAdd(bits(), static_cast<typename Ops::Bits>(value)));
+#else
+		return __atomic_fetch_add(&mValue, value, __ATOMIC_SEQ_CST);
+#endif
+	}
+
+	/// Writes desired if the value is still expected.
+	/// @param expected The value that has to be there. Filled with the value
+	///  that was actually there if the exchange failed.
+	/// @return true if desired was written, false otherwise.
+	FORCE_INLINE bool compareExchange(T &expected, T desired)
+	{
+#ifdef _MSC_VER
+		typedef AtomicDetail::Ops<sizeof(T)> Ops;
+		typedef typename Ops::Bits Bits;
+		const Bits expectedBits = AtomicDetail::bitCast<Bits>(expected);
+		const Bits previous = Ops::compareExchange(bits(), AtomicDetail::bitCast<Bits>(desired), expectedBits);
+		if (previous == expectedBits)
+			return true;
+		expected = AtomicDetail::bitCast<T>(previous);
+		return false;
+#else
+		return __atomic_compare_exchange_n(&mValue, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+	}
+
+private:
+	// 8 byte values are only 4 byte aligned on 32 bit x86 by default, which
+	// would split them over two cache lines at times.
+	alignas(sizeof(T)) T mValue;
+
+	static_assert(sizeof(T) == 4 || sizeof(T) == 8, "Atomic only supports 4 and 8 byte types.");
+
+#ifdef _MSC_VER
+	FORCE_INLINE volatile typename AtomicDetail::Ops<sizeof(T)>::Bits* bits()
+	{
+		return reinterpret_cast<volatile typename AtomicDetail::Ops<sizeof(T)>::Bits*>(&mValue);
+	}
+#else
+	static FORCE_INLINE int toBuiltinOrder(MemoryOrder order)
+	{
+		switch (order)
+		{
+		case eMemoryOrderRelaxed:
+			return __ATOMIC_RELAXED;
+		case eMemoryOrderAcquire:
+			return __ATOMIC_ACQUIRE;
+		case eMemoryOrderRelease:
+			return __ATOMIC_RELEASE;
+		default:
+			return __ATOMIC_SEQ_CST;
+		}
+	}
+#endif
+};
+
+#endif // _JBL_ATOMIC_HPP_
@@ -0,0 +1,182 @@
+//-----------------------------------------------------------------------------
+// bloomFilter.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_BLOOMFILTER_HPP_
+#define _JBL_BLOOMFILTER_HPP_
+
+#include <math.h>
+#include <string.h>
+#include "compiler.hpp"
+#include "lib.hpp"
+#include "hashFunction.hpp"
+
+/// A set that answers "maybe" or "definitely not", in a fraction of the
+/// memory of the keys themselves. Keys cannot be removed; use CuckooFilter
+/// for that.
+///
+/// This is a split block Bloom filter. Every key goes to a single 32 byte
+/// block, and sets one bit in each of the block's eight 32 bit words. A
+/// lookup touches one cache line, and with SSE2 the whole block is tested
+/// with two compares. Keys are hashed once with Hash, and everything else
+/// is derived from that hash.
+template<typename T, class Hash = HashFunction<T>>
+class BloomFilter
+{
+public:
+	/// The type that keys are looked up by. For String keys this is a
+	/// StringView, the same as for Dictionary.
+	typedef typename LookupKeyType<T>::Type LookupKey;
+
+	/// Creates a BloomFilter.
+	/// @param expectedCount The amount of keys that will be inserted.
+	/// @param falsePositiveRate The rate at which mayContain() may answer
+	///  true for keys that were never inserted, once expectedCount keys are
+	///  in the filter.
+	explicit BloomFilter(S32 expectedCount, F32 falsePositiveRate = 0.01f)
+	{
+		mBlockCount = blockCountFor(expectedCount, falsePositiveRate);
+		mBlocks = static_cast<Block*>(alignedMalloc(sizeof(Block) * mBlockCount, sizeof(Block)));
+		clear();
+	}
+
+	BloomFilter(const BloomFilter &) = delete;
+	BloomFilter& operator=(const BloomFilter &) = delete;
+
+	~BloomFilter()
+	{
+		alignedFree(mBlocks);
+	}
+
+	/// Adds a key to the filter.
+	/// @param key The key to add.
+	void insert(const LookupKey &key)
+	{
+		const U64 hash = hashKey(key);
+		Block &block = mBlocks[blockFor(hash)];
+		U32 mask[eWordsPerBlock];
+		makeMask(static_cast<U32>(hash), mask);
+
+#ifdef SSE_INTRINSICS
+		__m128i *words = reinterpret_cast<__m128i*>(block.words);
+		_mm_store_si128(words, _mm_or_si128(_mm_load_si128(words), _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask))));
+		_mm_store_si128(words + 1, _mm_or_si128(_mm_load_si128(words + 1), _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + 4))));
+#else
+		for (S32 i = 0; i < eWordsPerBlock; ++i)
+			block.words[i] |= mask[i];
+#endif
+	}
+
+	/// Checks to see if a key may have been added.
+	/// @param key The key to look for.
+	/// @return false if the key was definitely never added, true if it may
+	///  have been.
+	bool mayContain(const LookupKey &key) const
+	{
+		const U64 hash = hashKey(key);
+		const Block &block = mBlocks[blockFor(hash)];
+		U32 mask[eWordsPerBlock];
+		makeMask(static_cast<U32>(hash), mask);
+
+#ifdef SSE_INTRINSICS
+		const __m128i *words = reinterpret_cast<const __m128i*>(block.words);
+		const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+		const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask + 4));
+		const __m128i lowMatch = _mm_cmpeq_epi32(_mm_and_si128(_mm_load_si128(words), low), low);
+		const __m128i highMatch = _mm_cmpeq_epi32(_mm_and_si128(_mm_load_si128(words + 1), high), high);
+		return _mm_movemask_epi8(_mm_and_si128(lowMatch, highMatch)) == 0xFFFF;
+#else
+		U32 missing = 0;
+		for (S32 i = 0; i < eWordsPerBlock; ++i)
+			missing |= mask[i] & ~block.words[i];
+		return missing == 0;
+#endif
+	}
+
+	/// Removes every key from the filter.
+	void clear()
+	{
+		memset(mBlocks, 0, sizeof(Block) * mBlockCount);
+	}
+
+	/// Gets the amount of memory the filter takes up.
+	/// @return The size of the filter in bytes.
+	FORCE_INLINE size_t byteSize() const
+	{
+		return sizeof(Block) * static_cast<size_t>(mBlockCount);
+	}
+
+private:
+	enum Constants
+	{
+		eWordsPerBlock = 8
+	};
+
+	struct alignas(32) Block
+	{
+		U32 words[eWordsPerBlock];
+	};
+
+	Block *mBlocks;
+	S32 mBlockCount;
+
+	static S32 blockCountFor(S32 expectedCount, F32 falsePositiveRate)
+	{
+		// A filter that sets k bits per key needs -k / ln(1 - p^(1/k)) bits
+		// per key. Putting every key into one block makes some blocks fuller
+		// than others, which the extra quarter makes up for.
+		const F64 rate = mMin(mMax(static_cast<F64>(falsePositiveRate), 1.0e-6), 0.5);
+		const F64 bitsPerKey = -eWordsPerBlock / log(1.0 - pow(rate, 1.0 / eWordsPerBlock)) * 1.25;
+		const F64 bits = bitsPerKey * mMax(expectedCount, 1);
+		return mMax(static_cast<S32>(ceil(bits / (sizeof(Block) * 8))), 1);
+	}
+
+	FORCE_INLINE U64 hashKey(const LookupKey &key) const
+	{
+		Hash hash;
+
+		// Finalize again, so that every bit of the hash affects the block
+		// and the bits within it even for a weak Hash.
+		return finalizeHash64(static_cast<U64>(hash(key)));
+	}
+
+	/// Picks a block with the top 32 bits of the hash, without a division.
+	FORCE_INLINE U32 blockFor(U64 hash) const
+	{
+		return static_cast<U32>(((hash >> 32) * static_cast<U64>(mBlockCount)) >> 32);
+	}
+
+	/// Picks one bit in every word with the low 32 bits of the hash. Every
+	/// word multiplies by its own odd salt and takes the top 5 bits.
+	static FORCE_INLINE void makeMask(U32 hash, U32 *mask)
+	{
+		static const U32 salts[eWordsPerBlock] = {
+			0x47B6137BU, 0x44974D91U, 0x8824AD5BU, 0xA2B7289DU,
+			0x705495C7U, 0x2DF1424BU, 0x9EFC4947U, 0x5C6BFB31U
+		};
+		for (S32 i = 0; i < eWordsPerBlock; ++i)
+			mask[i] = 1U << ((hash * salts[i]) >> 27);
+	}
+};
+
+#endif // _JBL_BLOOMFILTER_HPP_
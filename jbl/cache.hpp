@@ -0,0 +1,387 @@
+//-----------------------------------------------------------------------------
+// cache.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_CACHE_HPP_
+#define _JBL_CACHE_HPP_
+
+#include <assert.h>
+#include "lib.hpp"
+#include "hashFunction.hpp"
+#include "memoryChunker.hpp"
+#include "dictionary.hpp"
+
+/// The shared part of LruCache and SieveCache: a map with a fixed capacity
+/// that evicts an element whenever a new key would go over it.
+///
+/// Elements live in nodes that come from a MemoryChunker, and a Dictionary
+/// maps keys to them. The nodes are linked into a list by pointers within
+/// the nodes themselves. The dictionary is reserved for the full capacity
+/// up front and evicted nodes are reused, so once a cache is full, neither
+/// hits nor evictions allocate anything.
+///
+/// Derived is the eviction policy. It provides touch(Node*), which is
+/// called on every hit, unlinking(Node*), which is called before a node
+/// leaves the list, victim(), which picks the node to evict, and reset(),
+/// which is called after the cache was cleared.
+template<class Derived, typename DictionaryKey, typename DictionaryValue, class Hash>
+class CacheBase
+{
+public:
+	/// The type that keys are looked up by. For String keys this is a
+	/// StringView, the same as for Dictionary.
+	typedef typename LookupKeyType<DictionaryKey>::Type LookupKey;
+
+	/// Called with every element that is evicted, right before it is
+	/// destroyed. The value may be moved out of. Elements that are erased or
+	/// cleared are not passed to it.
+	typedef void(*EvictionCallback)(const DictionaryKey &key, DictionaryValue &value, void *userData);
+
+	/// Creates a cache.
+	/// @param capacity The amount of elements the cache holds at most.
+	explicit CacheBase(S32 capacity)
+	{
+		assert(capacity > 0);
+		mCapacity = mMax(capacity, 1);
+		mHead = nullptr;
+		mTail = nullptr;
+		mEvictionCallback = nullptr;
+		mEvictionUserData = nullptr;
+		mMap.reserve(mCapacity);
+	}
+
+	CacheBase(const CacheBase &) = delete;
+	CacheBase& operator=(const CacheBase &) = delete;
+
+	~CacheBase()
+	{
+		destroyNodes();
+	}
+
+	/// Sets the function that is called with every evicted element.
+	/// @param callback The function, or nullptr to stop calling one.
+	/// @param userData Passed on to every call of callback.
+	void setEvictionCallback(EvictionCallback callback, void *userData = nullptr)
+	{
+		mEvictionCallback = callback;
+		mEvictionUserData = userData;
+	}
+
+	/// Looks up a key and counts it as used.
+	/// @param key The key to look for.
+	/// @return The value of the key, or nullptr if the key is not cached.
+	///  The pointer stays valid until the element is evicted or erased.
+	DictionaryValue* find(const LookupKey &key)
+	{
+		Node *node = findNode(key);
+		if (node == nullptr)
+			return nullptr;
+
+		derived()->touch(node);
+		return &node->value;
+	}
+
+	/// Looks up a key without counting it as used.
+	/// @param key The key to look for.
+	/// @return The value of the key, or nullptr if the key is not cached.
+	const DictionaryValue* peek(const LookupKey &key) const
+	{
+		const Node *node = findNode(key);
+		return node != nullptr ? &node->value : nullptr;
+	}
+
+	/// Checks to see if the cache contains key, without counting it as used.
+	/// @param key The key to look for.
+	/// @return true if the key is cached, false otherwise.
+	bool contains(const LookupKey &key) const
+	{
+		return mMap.contains(key);
+	}
+
+	/// Inserts a key/value pair, or assigns value to the existing element if
+	/// the key is already cached. Either way the element counts as used. If
+	/// the cache is full, an element is evicted to make room.
+	/// @return true if the pair was inserted, false if it was assigned.
+	bool insertOrAssign(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		Node *node = findNode(key);
+		if (node != nullptr)
+		{
+			node->value = value;
+			derived()->touch(node);
+			return false;
+		}
+
+		if (mMap.count() == mCapacity)
+			evict(derived()->victim());
+
+		node = mPool.construct(key, value);
+		node->next = mHead;
+		if (mHead != nullptr)
+			mHead->previous = node;
+		else
+			mTail = node;
+		mHead = node;
+
+		mMap.insert(key, node);
+		return true;
+	}
+
+	/// Erases the element with the key. The eviction callback is not called.
+	/// @return true if an element was erased, false if the key was not cached.
+	bool erase(const LookupKey &key)
+	{
+		auto position = mMap.find(key);
+		if (position == mMap.end())
+			return false;
+
+		Node *node = position->value;
+		mMap.erase(position);
+		unlink(node);
+		mPool.destroy(node);
+		return true;
+	}
+
+	/// Removes every element from the cache. The eviction callback is not
+	/// called.
+	void clear()
+	{
+		destroyNodes();
+		mMap.clear();
+		mHead = nullptr;
+		mTail = nullptr;
+		derived()->reset();
+	}
+
+	/// Gets the amount of elements within the cache.
+	/// @return The amount of elements in the cache.
+	FORCE_INLINE S32 count() const
+	{
+		return mMap.count();
+	}
+
+	/// Gets the amount of elements the cache holds at most.
+	/// @return The capacity of the cache.
+	FORCE_INLINE S32 capacity() const
+	{
+		return mCapacity;
+	}
+
+protected:
+	struct Node
+	{
+		DictionaryKey key;
+		DictionaryValue value;
+
+		/// Towards the head, which is where new nodes go.
+		Node *previous;
+
+		/// Towards the tail.
+		Node *next;
+
+		/// Whether the node was hit since the policy last looked at it.
+		bool visited;
+
+		Node(const DictionaryKey &nodeKey, const DictionaryValue &nodeValue) :
+			key(nodeKey),
+			value(nodeValue),
+			previous(nullptr),
+			next(nullptr),
+			visited(false)
+		{
+		}
+	};
+
+	Node *mHead;
+	Node *mTail;
+
+	/// Takes a node out of the list, without destroying it.
+	void unlink(Node *node)
+	{
+		derived()->unlinking(node);
+
+		if (node->previous != nullptr)
+			node->previous->next = node->next;
+		else
+			mHead = node->next;
+
+		if (node->next != nullptr)
+			node->next->previous = node->previous;
+		else
+			mTail = node->previous;
+	}
+
+private:
+	Dictionary<DictionaryKey, Node*, Hash> mMap;
+	MemoryChunker<Node> mPool;
+	S32 mCapacity;
+	EvictionCallback mEvictionCallback;
+	void *mEvictionUserData;
+
+	FORCE_INLINE Derived* derived()
+	{
+		return static_cast<Derived*>(this);
+	}
+
+	FORCE_INLINE Node* findNode(const LookupKey &key) const
+	{
+		auto position = mMap.find(key);
+		return position != mMap.end() ? position->value : nullptr;
+	}
+
+	void evict(Node *node)
+	{
+		mMap.erase(mMap.find(node->key));
+		unlink(node);
+		if (mEvictionCallback != nullptr)
+			mEvictionCallback(node->key, node->value, mEvictionUserData);
+		mPool.destroy(node);
+	}
+
+	void destroyNodes()
+	{
+		Node *node = mHead;
+		while (node != nullptr)
+		{
+			Node *next = node->next;
+			mPool.destroy(node);
+			node = next;
+		}
+	}
+};
+
+/// A cache that evicts the element that was used least recently.
+///
+/// Every hit moves the element to the head of the list, which is a handful
+/// of pointer writes. Prefer SieveCache when hits are far more common than
+/// misses, as it does not write any links on a hit.
+template<typename DictionaryKey, typename DictionaryValue, class Hash = HashFunction<DictionaryKey>>
+class LruCache : public CacheBase<LruCache<DictionaryKey, DictionaryValue, Hash>, DictionaryKey, DictionaryValue, Hash>
+{
+	typedef CacheBase<LruCache, DictionaryKey, DictionaryValue, Hash> Base;
+	friend Base;
+	typedef typename Base::Node Node;
+
+public:
+	/// Creates a cache.
+	/// @param capacity The amount of elements the cache holds at most.
+	explicit LruCache(S32 capacity) : Base(capacity)
+	{
+	}
+
+private:
+	void touch(Node *node)
+	{
+		if (node == this->mHead)
+			return;
+
+		// Move it to the head. It is not the head, so it has a previous node.
+		node->previous->next = node->next;
+		if (node->next != nullptr)
+			node->next->previous = node->previous;
+		else
+			this->mTail = node->previous;
+
+		node->previous = nullptr;
+		node->next = this->mHead;
+		this->mHead->previous = node;
+		this->mHead = node;
+	}
+
+	FORCE_INLINE void unlinking(Node *)
+	{
+	}
+
+	FORCE_INLINE void reset()
+	{
+	}
+
+	FORCE_INLINE Node* victim() const
+	{
+		return this->mTail;
+	}
+};
+
+/// A cache that evicts with SIEVE: new elements go to the head of a queue,
+/// and a hit only sets the visited flag of its element. To evict, a hand
+/// walks from the tail towards the head, clearing the flags of visited
+/// elements and evicting the first element that was not visited. The hand
+/// stays where it stopped for the next eviction.
+///
+/// Unlike CLOCK, elements that survive are never moved, so elements that
+/// were just inserted are evicted quickly when they are not used again.
+/// This keeps popular elements cached about as well as LRU does, while a
+/// hit costs a lookup and a single store.
+template<typename DictionaryKey, typename DictionaryValue, class Hash = HashFunction<DictionaryKey>>
+class SieveCache : public CacheBase<SieveCache<DictionaryKey, DictionaryValue, Hash>, DictionaryKey, DictionaryValue, Hash>
+{
+	typedef CacheBase<SieveCache, DictionaryKey, DictionaryValue, Hash> Base;
+	friend Base;
+	typedef typename Base::Node Node;
+
+public:
+	/// Creates a cache.
+	/// @param capacity The amount of elements the cache holds at most.
+	explicit SieveCache(S32 capacity) : Base(capacity)
+	{
+		mHand = nullptr;
+	}
+
+private:
+	/// The next node to look at for eviction, or nullptr to start over at
+	/// the tail.
+	Node *mHand;
+
+	FORCE_INLINE void touch(Node *node)
+	{
+		node->visited = true;
+	}
+
+	FORCE_INLINE void unlinking(Node *node)
+	{
+		if (node == mHand)
+			mHand = node->previous;
+	}
+
+	FORCE_INLINE void reset()
+	{
+		mHand = nullptr;
+	}
+
+	Node* victim()
+	{
+		// Every node that is passed over loses its flag, so this finds a
+		// node within one lap of the queue.
+		Node *node = mHand != nullptr ? mHand : this->mTail;
+		while (node->visited)
+		{
+			node->visited = false;
+			node = node->previous != nullptr ? node->previous : this->mTail;
+		}
+
+		mHand = node->previous;
+		return node;
+	}
+};
+
+#endif // _JBL_CACHE_HPP_
@@ -40,6 +40,9 @@
 	// Macro to force inline a function
 	#define FORCE_INLINE __forceinline
 
+	// Macro to start loading the cache line at address into the cache
+	#define PREFETCH(address) _mm_prefetch((const char*)(address), _MM_HINT_T0)
+
 	// Macro for 32bit vs 64bit
 	#if defined(_M_X64)
 		#define IS_64_BIT
@@ -60,6 +63,9 @@
 	// Macro to force inline on a function
 	#define FORCE_INLINE __attribute__((always_inline)) inline
 
+	// Macro to start loading the cache line at address into the cache
+	#define PREFETCH(address) __builtin_prefetch(address)
+
 	// Macro for 32bit vs 64bit
 	#if defined(__x86_64__) || defined(__ppc64__)
 		#define IS_64_BIT
@@ -70,4 +76,8 @@
 	#error "Please implement these macros for your compiler."
 #endif
 
+// Size of a cache line in bytes. Data that different threads write to should
+// be kept on different cache lines.
+#define CACHE_LINE_SIZE 64
+
 #endif // _JBL_COMPILER_H_
@@ -0,0 +1,235 @@
+//-----------------------------------------------------------------------------
+// concurrentDictionary.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_CONCURRENTDICTIONARY_HPP_
+#define _JBL_CONCURRENTDICTIONARY_HPP_
+
+#include <new>
+#include "lib.hpp"
+#include "mutex.hpp"
+#include "dictionary.hpp"
+
+/// A Dictionary that can be shared between threads.
+///
+/// The key space is split into shards. Every shard is a Dictionary with its
+/// own Mutex, padded out to its own cache lines, so threads that work on
+/// keys in different shards never wait on each other or fight over the
+/// same cache line. A key always belongs to the same shard.
+///
+/// Elements are never handed out by reference, as another thread could
+/// erase them right after the shard is unlocked. Lookups copy the value
+/// out instead.
+template<typename DictionaryKey, typename DictionaryValue, class Hash = HashFunction<DictionaryKey>>
+class ConcurrentDictionary
+{
+public:
+	typedef Dictionary<DictionaryKey, DictionaryValue, Hash> ShardDictionary;
+	typedef typename ShardDictionary::LookupKey LookupKey;
+	typedef typename ShardDictionary::KVPair KVPair;
+
+private:
+	enum Constants
+	{
+		eDefaultShardCount = 32,
+		eMaxShardBits = 16
+	};
+
+	struct alignas(CACHE_LINE_SIZE) Shard
+	{
+		Mutex mutex;
+		ShardDictionary dictionary;
+	};
+
+public:
+	/// Creates a ConcurrentDictionary.
+	/// @param shardCount The amount of shards to split the keys into. It is
+	///  rounded up to a power of two. More shards than threads keeps the
+	///  chance of two threads wanting the same shard low.
+	explicit ConcurrentDictionary(S32 shardCount = eDefaultShardCount)
+	{
+		mShardBits = 0;
+		while ((1 << mShardBits) < shardCount && mShardBits < eMaxShardBits)
+			++mShardBits;
+		mShardCount = 1 << mShardBits;
+
+		// new does not have to respect the alignment of Shard.
+		mShards = static_cast<Shard*>(alignedMalloc(sizeof(Shard) * mShardCount, CACHE_LINE_SIZE));
+		for (S32 i = 0; i < mShardCount; ++i)
+			new (&mShards[i]) Shard();
+	}
+
+	ConcurrentDictionary(const ConcurrentDictionary &) = delete;
+	ConcurrentDictionary& operator=(const ConcurrentDictionary &) = delete;
+
+	~ConcurrentDictionary()
+	{
+		for (S32 i = 0; i < mShardCount; ++i)
+			mShards[i].~Shard();
+		alignedFree(mShards);
+	}
+
+	/// Inserts a key/value pair if the key is not within the dictionary yet.
+	/// @return true if the pair was inserted, false if the key was already
+	///  there.
+	bool insert(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		const size_t keyHash = hashKey(key);
+		Shard &shard = shardFor(keyHash);
+		LockGuard guard(&shard.mutex);
+		return shard.dictionary.tryEmplaceWithHash(keyHash, key, value).inserted;
+	}
+
+	/// Inserts a key/value pair, or assigns value to the existing element if
+	/// the key is already within the dictionary.
+	/// @return true if the pair was inserted, false if it was assigned.
+	bool insertOrAssign(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		const size_t keyHash = hashKey(key);
+		Shard &shard = shardFor(keyHash);
+		LockGuard guard(&shard.mutex);
+		return shard.dictionary.insertOrAssignWithHash(keyHash, key, value).inserted;
+	}
+
+	/// Looks up a key and copies its value out.
+	/// @param key The key to look for.
+	/// @param value Filled with a copy of the value if the key was found.
+	/// @return true if the key was found, false otherwise.
+	bool find(const LookupKey &key, DictionaryValue &value) const
+	{
+		const size_t keyHash = hashKey(key);
+		Shard &shard = shardFor(keyHash);
+		LockGuard guard(&shard.mutex);
+
+		const ShardDictionary &dictionary = shard.dictionary;
+		auto position = dictionary.findWithHash(key, keyHash);
+		if (position == dictionary.end())
+			return false;
+		value = position->value;
+		return true;
+	}
+
+	/// Checks to see if the dictionary contains key.
+	/// @param key The key to look for.
+	/// @return true if the key is within the dictionary, false otherwise.
+	bool contains(const LookupKey &key) const
+	{
+		const size_t keyHash = hashKey(key);
+		Shard &shard = shardFor(keyHash);
+		LockGuard guard(&shard.mutex);
+		return shard.dictionary.containsWithHash(key, keyHash);
+	}
+
+	/// Erases the element with the key.
+	/// @param key The key of the element to erase.
+	/// @return true if an element was erased, false if the key was not found.
+	bool erase(const LookupKey &key)
+	{
+		const size_t keyHash = hashKey(key);
+		Shard &shard = shardFor(keyHash);
+		LockGuard guard(&shard.mutex);
+
+		auto position = shard.dictionary.findWithHash(key, keyHash);
+		if (position == shard.dictionary.end())
+			return false;
+		shard.dictionary.erase(position);
+		return true;
+	}
+
+	/// Calls fn for every element, one shard at a time. Only the shard that
+	/// is being visited is locked, so other threads can keep working on the
+	/// rest of the dictionary. This also means that the visit is not a
+	/// snapshot of the whole dictionary at a single point in time.
+	/// @param fn Called as fn(const KVPair &) for every element. It must not
+	///  call back into this dictionary.
+	template<typename Function>
+	void forEach(Function fn) const
+	{
+		for (S32 i = 0; i < mShardCount; ++i)
+		{
+			LockGuard guard(&mShards[i].mutex);
+
+			const ShardDictionary &dictionary = mShards[i].dictionary;
+			for (const KVPair &pair : dictionary)
+				fn(pair);
+		}
+	}
+
+	/// Removes every element from the dictionary, one shard at a time.
+	void clear()
+	{
+		for (S32 i = 0; i < mShardCount; ++i)
+		{
+			LockGuard guard(&mShards[i].mutex);
+			mShards[i].dictionary.clear();
+		}
+	}
+
+	/// Gets the amount of elements within the dictionary. Other threads can
+	/// change the dictionary while the shards are being counted, so this is
+	/// only exact while nobody else is writing.
+	/// @return The amount of elements in the dictionary.
+	S32 count() const
+	{
+		S32 total = 0;
+		for (S32 i = 0; i < mShardCount; ++i)
+		{
+			LockGuard guard(&mShards[i].mutex);
+			total += mShards[i].dictionary.count();
+		}
+		return total;
+	}
+
+	/// Gets the amount of shards that the keys are split into.
+	/// @return The amount of shards.
+	FORCE_INLINE S32 shardCount() const
+	{
+		return mShardCount;
+	}
+
+private:
+	Shard *mShards;
+	S32 mShardCount;
+	S32 mShardBits;
+
+	/// Hashes a key once for both the shard and the shard Dictionary, which
+	/// takes the hash through its WithHash calls.
+	template<typename K>
+	static FORCE_INLINE size_t hashKey(const K &key)
+	{
+		Hash hash;
+		return hash(key);
+	}
+
+	/// Picks the shard of a key by its hash. The shard Dictionaries pick
+	/// their buckets from the same hash, so the shard comes from a separate
+	/// finalizer mix of it. Otherwise every key of a shard would share the
+	/// bits that pick the bucket, and pile up in a fraction of the buckets.
+	Shard& shardFor(size_t keyHash) const
+	{
+		const size_t mixed = finalizeHash(keyHash);
+		return mShards[static_cast<S32>(mixed & static_cast<U32>(mShardCount - 1))];
+	}
+};
+
+#endif // _JBL_CONCURRENTDICTIONARY_HPP_
@@ -0,0 +1,276 @@
+//-----------------------------------------------------------------------------
+// cuckooFilter.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_CUCKOOFILTER_HPP_
+#define _JBL_CUCKOOFILTER_HPP_
+
+#include <stdlib.h>
+#include <string.h>
+#include "lib.hpp"
+#include "hashFunction.hpp"
+
+/// A set that answers "maybe" or "definitely not" like BloomFilter, but
+/// that also supports removing keys.
+///
+/// Every key is stored as a 16 bit fingerprint in one of two buckets of
+/// four slots. The second bucket can be computed from the first and the
+/// fingerprint alone, so fingerprints can be moved between their buckets
+/// to make room, the way cuckoo hashing does. A bucket is a single U64, so
+/// a lookup reads two words and matches all four slots of each at once.
+///
+/// False positives happen at a rate of about 1 in 8000. Only erase keys
+/// that were inserted: erasing a key that only seems to be there removes
+/// the fingerprint of another key. A key that is inserted twice has to be
+/// erased twice.
+template<typename T, class Hash = HashFunction<T>>
+class CuckooFilter
+{
+public:
+	/// The type that keys are looked up by. For String keys this is a
+	/// StringView, the same as for Dictionary.
+	typedef typename LookupKeyType<T>::Type LookupKey;
+
+	/// Creates a CuckooFilter.
+	/// @param expectedCount The amount of keys the filter has to hold.
+	explicit CuckooFilter(S32 expectedCount)
+	{
+		mBuckets = nullptr;
+		reset(expectedCount);
+	}
+
+	CuckooFilter(const CuckooFilter &) = delete;
+	CuckooFilter& operator=(const CuckooFilter &) = delete;
+
+	~CuckooFilter()
+	{
+		free(mBuckets);
+	}
+
+	/// Removes every key and resizes the filter.
+	/// @param expectedCount The amount of keys the filter has to hold.
+	void reset(S32 expectedCount)
+	{
+		// Four slots per bucket can be filled to about 95%.
+		const S32 needed = mMax(expectedCount, 1) * 100 / (eSlotsPerBucket * eMaxLoadPercent) + 1;
+		U32 bucketCount = 1;
+		while (bucketCount < static_cast<U32>(needed))
+			bucketCount <<= 1;
+
+		free(mBuckets);
+		mBuckets = static_cast<U64*>(malloc(sizeof(U64) * bucketCount));
+		mBucketMask = bucketCount - 1;
+		mRandom = 0x9E3779B9U;
+		clear();
+	}
+
+	/// Adds a key to the filter.
+	/// @param key The key to add.
+	/// @return true if the key was added, false if the filter was full
+	///  already. A full filter has to be reset with a larger size.
+	bool insert(const LookupKey &key)
+	{
+		if (mHasVictim)
+			return false;
+
+		U16 fingerprint;
+		U32 bucket;
+		locate(key, fingerprint, bucket);
+		++mCount;
+
+		if (tryStore(bucket, fingerprint) || tryStore(alternate(bucket, fingerprint), fingerprint))
+			return true;
+
+		// Both buckets are full. Kick a random fingerprint out and move it
+		// to its other bucket, until one lands in a free slot.
+		for (S32 kick = 0; kick < eMaxKicks; ++kick)
+		{
+			mRandom ^= mRandom << 13;
+			mRandom ^= mRandom >> 17;
+			mRandom ^= mRandom << 5;
+			const U32 shift = (mRandom % eSlotsPerBucket) * 16;
+
+			const U16 kicked = static_cast<U16>(mBuckets[bucket] >> shift);
+			mBuckets[bucket] = (mBuckets[bucket] & ~(static_cast<U64>(0xFFFF) << shift)) | (static_cast<U64>(fingerprint) << shift);
+			fingerprint = kicked;
+			bucket = alternate(bucket, fingerprint);
+
+			if (tryStore(bucket, fingerprint))
+				return true;
+		}
+
+		// The last fingerprint that was kicked out has nowhere to go. Keep it
+		// on the side so that no key that was inserted before goes missing.
+		mHasVictim = true;
+		mVictimFingerprint = fingerprint;
+		mVictimBucket = bucket;
+		return true;
+	}
+
+	/// Checks to see if a key may have been added.
+	/// @param key The key to look for.
+	/// @return false if the key was definitely never added or was erased,
+	///  true if it may have been added.
+	bool mayContain(const LookupKey &key) const
+	{
+		U16 fingerprint;
+		U32 bucket;
+		locate(key, fingerprint, bucket);
+		const U32 other = alternate(bucket, fingerprint);
+
+		if (hasFingerprint(mBuckets[bucket], fingerprint) || hasFingerprint(mBuckets[other], fingerprint))
+			return true;
+		return mHasVictim && mVictimFingerprint == fingerprint && (mVictimBucket == bucket || mVictimBucket == other);
+	}
+
+	/// Removes a key that was added before.
+	/// @param key The key to remove.
+	/// @return true if a fingerprint of the key was removed, false if the
+	///  key was definitely never added.
+	bool erase(const LookupKey &key)
+	{
+		U16 fingerprint;
+		U32 bucket;
+		locate(key, fingerprint, bucket);
+		const U32 other = alternate(bucket, fingerprint);
+
+		if (mHasVictim && mVictimFingerprint == fingerprint && (mVictimBucket == bucket || mVictimBucket == other))
+			mHasVictim = false;
+		else if (!tryRemove(bucket, fingerprint) && !tryRemove(other, fingerprint))
+			return false;
+
+		--mCount;
+
+		// There is room now, so the victim may fit into one of its buckets.
+		if (mHasVictim && (tryStore(mVictimBucket, mVictimFingerprint) || tryStore(alternate(mVictimBucket, mVictimFingerprint), mVictimFingerprint)))
+			mHasVictim = false;
+		return true;
+	}
+
+	/// Removes every key from the filter.
+	void clear()
+	{
+		memset(mBuckets, 0, sizeof(U64) * (static_cast<size_t>(mBucketMask) + 1));
+		mCount = 0;
+		mHasVictim = false;
+		mVictimFingerprint = 0;
+		mVictimBucket = 0;
+	}
+
+	/// Gets the amount of keys within the filter.
+	/// @return The amount of keys that were inserted and not erased.
+	FORCE_INLINE S32 count() const
+	{
+		return mCount;
+	}
+
+	/// Checks to see if the filter is full. The next insert will fail.
+	/// @return true if the filter is full, false otherwise.
+	FORCE_INLINE bool isFull() const
+	{
+		return mHasVictim;
+	}
+
+	/// Gets the amount of memory the filter takes up.
+	/// @return The size of the filter in bytes.
+	FORCE_INLINE size_t byteSize() const
+	{
+		return sizeof(U64) * (static_cast<size_t>(mBucketMask) + 1);
+	}
+
+private:
+	enum Constants
+	{
+		eSlotsPerBucket = 4,
+		eMaxLoadPercent = 95,
+		eMaxKicks = 500
+	};
+
+	/// Four 16 bit slots per bucket. An empty slot is 0.
+	U64 *mBuckets;
+	U32 mBucketMask;
+	S32 mCount;
+	U32 mRandom;
+
+	bool mHasVictim;
+	U16 mVictimFingerprint;
+	U32 mVictimBucket;
+
+	FORCE_INLINE void locate(const LookupKey &key, U16 &fingerprint, U32 &bucket) const
+	{
+		Hash hash;
+
+		// Finalize again, so that the bucket and the fingerprint both
+		// depend on every bit of the hash even for a weak Hash.
+		const U64 mixed = finalizeHash64(static_cast<U64>(hash(key)));
+
+		// 0 marks empty slots, so it is not a valid fingerprint.
+		fingerprint = static_cast<U16>(mixed >> 48);
+		fingerprint += static_cast<U16>(fingerprint == 0);
+		bucket = static_cast<U32>(mixed) & mBucketMask;
+	}
+
+	/// The other bucket of a fingerprint. Applying it twice gives back the
+	/// bucket it started with.
+	FORCE_INLINE U32 alternate(U32 bucket, U16 fingerprint) const
+	{
+		return (bucket ^ (static_cast<U32>(fingerprint) * 0x5BD1E995U)) & mBucketMask;
+	}
+
+	/// Checks all four slots at once: the slot that holds the fingerprint
+	/// becomes zero after the xor, and the subtraction borrows out of it.
+	static FORCE_INLINE bool hasFingerprint(U64 bucket, U16 fingerprint)
+	{
+		const U64 ones = 0x0001000100010001ULL;
+		const U64 x = bucket ^ (ones * fingerprint);
+		return ((x - ones) & ~x & (ones << 15)) != 0;
+	}
+
+	bool tryStore(U32 bucket, U16 fingerprint)
+	{
+		for (U32 shift = 0; shift < 64; shift += 16)
+		{
+			if (((mBuckets[bucket] >> shift) & 0xFFFF) == 0)
+			{
+				mBuckets[bucket] |= static_cast<U64>(fingerprint) << shift;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool tryRemove(U32 bucket, U16 fingerprint)
+	{
+		for (U32 shift = 0; shift < 64; shift += 16)
+		{
+			if (((mBuckets[bucket] >> shift) & 0xFFFF) == fingerprint)
+			{
+				mBuckets[bucket] &= ~(static_cast<U64>(0xFFFF) << shift);
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+#endif // _JBL_CUCKOOFILTER_HPP_
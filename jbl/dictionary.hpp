@@ -25,54 +25,284 @@
 #ifndef _JBL_DICTIONARY_HPP_
 #define _JBL_DICTIONARY_HPP_
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <new>
 #include "typetraits.hpp"
 #include "memoryChunker.hpp"
 #include "hashFunction.hpp"
+#include "threadTasks.hpp"
+#include "vector.hpp"
 
-template<typename DictionaryKey, typename DictionaryValue, class Hash = HashFunction<DictionaryKey>>
+/// A snapshot of how well a Dictionary is spreading its keys, and how much
+/// memory it takes up. See Dictionary::stats().
+struct DictionaryStats
+{
+	enum Constants
+	{
+		eChainHistogramSize = 8
+	};
+
+	/// The amount of elements.
+	S32 count;
+
+	/// The amount of buckets. While an incremental rehash is running, this
+	/// counts the buckets of both tables.
+	S32 bucketCount;
+
+	/// The amount of buckets that hold at least one element.
+	S32 usedBuckets;
+
+	/// The average amount of elements per bucket of the current table.
+	F32 loadFactor;
+
+	/// The amount of elements within the fullest bucket.
+	S32 maxChainLength;
+
+	/// The average amount of keys that a lookup of a key that is within the
+	/// dictionary compares against. 1.0 is perfect.
+	F32 averageProbeLength;
+
+	/// chainHistogram[n] is the amount of buckets that hold n elements. The
+	/// last entry also counts every bucket that holds more.
+	S32 chainHistogram[eChainHistogramSize];
+
+	/// The amount of memory taken by the tables, in bytes.
+	size_t tableBytes;
+
+	/// The amount of memory taken by the pages of the cell pool, in bytes.
+	size_t poolBytes;
+
+	/// The amount of pages within the cell pool.
+	S32 poolPages;
+
+	/// The amount of elements that live in the pool instead of the table.
+	S32 chainedCells;
+
+	/// The amount of pool cells that were erased and wait to be reused.
+	S32 freeCells;
+
+	/// Whether an incremental rehash was running.
+	bool rehashing;
+};
+
+/// Prints a DictionaryStats in a human readable form, for debugging.
+/// @param stats The stats to print.
+/// @param file Where to print them to.
+inline void dumpDictionaryStats(const DictionaryStats &stats, FILE *file = stdout)
+{
+	fprintf(file, "Dictionary: %d elements in %d buckets (%d used), load factor %.2f%s\n",
+		stats.count, stats.bucketCount, stats.usedBuckets, stats.loadFactor, stats.rehashing ? ", rehashing" : "");
+	fprintf(file, " chains: longest %d, average probe length %.2f\n", stats.maxChainLength, stats.averageProbeLength);
+	for (S32 i = 0; i < DictionaryStats::eChainHistogramSize; ++i)
+	{
+		const bool last = i == DictionaryStats::eChainHistogramSize - 1;
+		fprintf(file, "  %d%s: %d buckets\n", i, last ? "+" : "", stats.chainHistogram[i]);
+	}
+	fprintf(file, " memory: %u bytes of table, %u bytes in %d pool pages\n",
+		static_cast<U32>(stats.tableBytes), static_cast<U32>(stats.poolBytes), stats.poolPages);
+	fprintf(file, " pool cells: %d chained, %d free\n", stats.chainedCells, stats.freeCells);
+}
+
+/// Bucket policy that keeps tables at a power of two and picks a bucket with
+/// one multiply and one shift. Multiplying by 2^n divided by the golden
+/// ratio spreads the hash over the top bits, so keys with a regular
+/// pattern, such as the identity hash of multiples of 6, still spread over
+/// every bucket.
+class FibonacciBuckets
+{
+public:
+	/// Rounds an amount of buckets up to the nearest power of two.
+	static size_t roundBucketCount(size_t count)
+	{
+		size_t buckets = 2;
+		while (buckets < count)
+			buckets <<= 1;
+		return buckets;
+	}
+
+	void setBucketCount(size_t count)
+	{
+		assert(count >= 2 && (count & (count - 1)) == 0);
+		mShift = static_cast<U32>(sizeof(size_t) * 8) - countTrailingZeros(static_cast<U64>(count));
+	}
+
+	FORCE_INLINE size_t bucketIndex(size_t hash) const
+	{
+#ifdef IS_64_BIT
+		return (hash * static_cast<size_t>(0x9E3779B97F4A7C15ULL)) >> mShift;
+#else
+		return (hash * static_cast<size_t>(0x9E3779B9U)) >> mShift;
+#endif
+	}
+
+private:
+	U32 mShift = 0;
+};
+
+/// Bucket policy that allows any amount of buckets and picks a bucket with
+/// hash % bucketCount. This costs a divide per lookup, but leaves the
+/// bucket up to the hash alone, for hash functions that are already well
+/// distributed modulo a prime bucket count.
+class ModuloBuckets
+{
+public:
+	static size_t roundBucketCount(size_t count)
+	{
+		return mMax(count, static_cast<size_t>(1));
+	}
+
+	void setBucketCount(size_t count)
+	{
+		mBucketCount = count;
+	}
+
+	FORCE_INLINE size_t bucketIndex(size_t hash) const
+	{
+		return hash % mBucketCount;
+	}
+
+private:
+	size_t mBucketCount = 1;
+};
+
+template<typename DictionaryKey, typename DictionaryValue, class Hash = HashFunction<DictionaryKey>, class BucketPolicy = FibonacciBuckets>
 class Dictionary
 {
 private:
-	struct Cell
+	/// Tag that selects the in place constructor of KVPair.
+	struct InPlace {};
+
+public:
+	/// The type that keys are looked up by. For String keys this is a
+	/// StringView, so looking up a literal or a raw buffer never has to
+	/// construct a String. A custom Hash for String keys has to be able to
+	/// hash a StringView the same way as the equivalent String.
+	typedef typename LookupKeyType<DictionaryKey>::Type LookupKey;
+
+	/// Has a member type of R when K is the stored key type and differs from
+	/// LookupKey. It picks the overloads that take a String key whole rather
+	/// than as a view, so that a hash that the String has cached is reused.
+	template<typename K, typename R>
+	struct StoredKeyOverload : TypeTraits::EnableIf<TypeTraits::IsSame<K, DictionaryKey>::value && !TypeTraits::IsSame<DictionaryKey, LookupKey>::value, R> {};
+
+	/// A key/value pair within the Dictionary. Iterators hand out references
+	/// to the pairs that are stored within the table, so the key of a pair
+	/// that belongs to a Dictionary must never be modified.
+	struct KVPair
 	{
 		DictionaryKey key;
 		DictionaryValue value;
 
+		KVPair() : key(), value() {}
+
+		KVPair(const DictionaryKey &pairKey, const DictionaryValue &pairValue) :
+			key(pairKey),
+			value(pairValue)
+		{
+		}
+
+	protected:
+		/// Constructs the key from pairKey and the value in place from the
+		/// rest of the arguments.
+		template<typename K, typename... Args>
+		KVPair(InPlace, K &&pairKey, Args&&... valueArgs) :
+			key(static_cast<K&&>(pairKey)),
+			value(static_cast<Args&&>(valueArgs)...)
+		{
+		}
+	};
+
+private:
+	struct Cell : KVPair
+	{
+		/// The full hash of the key. Lookups compare it before comparing
+		/// keys, and rehashing never has to hash a key again.
+		size_t hash;
+
 		Cell *next = nullptr;
 		Cell *previous = nullptr;
+
+		template<typename K, typename... Args>
+		Cell(size_t keyHash, K &&cellKey, Args&&... valueArgs) :
+			KVPair(InPlace(), static_cast<K&&>(cellKey), static_cast<Args&&>(valueArgs)...),
+			hash(keyHash)
+		{
+		}
 	};
 
+	/// The first cell of every bucket lives inside of the table. The table
+	/// is zeroed memory, so the Cell part of a TableCell is only constructed
+	/// while hasData is true.
+	///
+	/// Every table is followed by an occupancy bitmap in the same block of
+	/// memory, with one bit per bucket that mirrors hasData. Iteration scans
+	/// the bitmap instead of the cells, so it skips 64 empty buckets at a
+	/// time without loading them.
 	struct TableCell : Cell
 	{
 		bool hasData = false;
 	};
 
-	template<typename T>
-	FORCE_INLINE size_t hashWithTableSize(T &ref)
+	enum Constants
 	{
-		Hash hash;
-		return hash(ref) % static_cast<size_t>(mTableSize);
-	}
+		eDefaultBucketSize = 16,
 
-public:
-	struct KVPair
+		// Old buckets moved per call during an incremental rehash.
+		eDefaultMigrateStep = 4,
+
+		// Keys that are hashed and prefetched together by the batch calls.
+		eBatchGroupSize = 16,
+
+		// buildParallel gives every thread at least this many pairs.
+		eMinParallelBuildPairs = 4096
+	};
+
+	/// What the threads of buildParallel share.
+	struct BuildJob
 	{
-		DictionaryKey key;
-		DictionaryValue value;
+		Dictionary *dictionary;
+		const KVPair *pairs;
+		S32 pairCount;
+		S32 threadCount;
+
+		/// The hash of every pair.
+		size_t *hashes;
+
+		/// The positions of the pairs, sorted by range.
+		S32 *order;
+
+		/// For every slice of pairs and every range, where in order the next
+		/// pair of the slice that belongs to the range goes.
+		S32 *offsets;
+
+		/// Where the pairs of every range start within order, plus the end.
+		S32 *rangeStarts;
 	};
 
+	/// One thread of buildParallel. It hashes and sorts one slice of the
+	/// pairs, and fills one range of buckets.
+	struct BuildTask
+	{
+		BuildJob *job;
+		S32 index;
+		size_t inserted;
+		MemoryChunker<Cell> pool;
+	};
+
+public:
 	/// A class that is responsible for iterating over a Dictionary.
-	/// It performs forward iteration at O(n) time.
+	/// It performs forward iteration at O(n) time. Dereferencing gives a
+	/// reference to the pair stored within the Dictionary, nothing is copied.
 	/// @see CIterator
 	class Iterator
 	{
-		friend class Dictionary<DictionaryKey, DictionaryValue, Hash>;
+		friend class Dictionary;
 	public:
-		Iterator(Dictionary *dictionary, S32 tablePosStart)
+		Iterator(Dictionary *dictionary, size_t tablePosStart)
 		{
 			mDictionary = dictionary;
-			mCurrentCell = nullptr;
 
 			// Find first tablecell within the table that has something
 			// If the table is empty, mTablePos will simply incriment to
@@ -102,49 +332,66 @@ public:
 			}
 			return *this;
 		}
-		
+
 		/// Compares if two iterators are at the same position.
 		/// @param it The other iterator to check.
 		/// @return true if both iterators are at the same position, false
 		///  otherwise.
-		bool operator!=(const Iterator &it) const
+		bool operator==(const Iterator &it) const
 		{
 			// Both dictionaries must be the same dictionary
 			// between iterators!
 			assert(mDictionary == it.mDictionary);
 
-			return mTablePos != it.mTablePos;
+			return mTablePos == it.mTablePos && mCurrentCell == it.mCurrentCell;
+		}
+
+		/// Compares if two iterators are at different positions.
+		/// @param it The other iterator to check.
+		/// @return true if the iterators are at different positions, false
+		///  otherwise.
+		bool operator!=(const Iterator &it) const
+		{
+			return !(*this == it);
 		}
 
 		/// Dereferences the current element at the current iterator position.
 		/// @return The key/value pair of the dictionary at the current position.
-		KVPair operator*() const
+		KVPair& operator*() const
 		{
 			assert(mCurrentCell != nullptr);
+			return *mCurrentCell;
+		}
 
-			KVPair pair;
-			pair.key = mCurrentCell->key;
-			pair.value = mCurrentCell->value;
-			return pair;
+		/// Accesses the current element at the current iterator position.
+		/// @return The key/value pair of the dictionary at the current position.
+		KVPair* operator->() const
+		{
+			assert(mCurrentCell != nullptr);
+			return mCurrentCell;
 		}
 	private:
 		Dictionary *mDictionary;
-		S32 mTablePos;
+		size_t mTablePos;
 		Cell *mCurrentCell;
 
+		/// Creates an iterator that points directly at a cell.
+		Iterator(Dictionary *dictionary, size_t tablePos, Cell *cell)
+		{
+			mDictionary = dictionary;
+			mTablePos = tablePos;
+			mCurrentCell = cell;
+		}
+
 		/// Advances the iterator to the next cell when it has to jump
-		/// to another bucket.
+		/// to another bucket. The current cell is nullptr at the end.
 		void findNextCell()
 		{
-			for (; mTablePos < mDictionary->mTableSize; ++mTablePos)
-			{
-				TableCell *cell = static_cast<TableCell*>(&mDictionary->mTable[mTablePos]);
-				if (cell->hasData)
-				{
-					mCurrentCell = static_cast<Cell*>(cell);
-					break;
-				}
-			}
+			mTablePos = mDictionary->nextOccupied(mTablePos);
+			if (mTablePos < mDictionary->tableEnd())
+				mCurrentCell = static_cast<Cell*>(mDictionary->tableCellAt(mTablePos));
+			else
+				mCurrentCell = nullptr;
 		}
 	};
 
@@ -155,12 +402,11 @@ public:
 public:
 	class CIterator
 	{
-		friend class Dictionary<DictionaryKey, DictionaryValue, Hash>;
+		friend class Dictionary;
 	public:
-		CIterator(Dictionary *dictionary, S32 tablePosStart)
+		CIterator(const Dictionary *dictionary, size_t tablePosStart)
 		{
 			mDictionary = dictionary;
-			mCurrentCell = nullptr;
 
 			// Find first tablecell within the table that has something
 			// If the table is empty, mTablePos will simply incriment to
@@ -172,7 +418,7 @@ public:
 
 		/// Incriments the iterator to advance it to access the next element.
 		/// @return The current iterator.
-		const CIterator& operator++()
+		CIterator& operator++()
 		{
 			// If the current cell is nullptr assert.
 			assert(mCurrentCell != nullptr);
@@ -195,13 +441,22 @@ public:
 		/// @param it The other iterator to check.
 		/// @return true if both iterators are at the same position, false
 		///  otherwise.
-		bool operator!=(const CIterator &it) const
+		bool operator==(const CIterator &it) const
 		{
 			// Both dictionaries must be the same dictionary
 			// between iterators!
 			assert(mDictionary == it.mDictionary);
 
-			return mTablePos != it.mTablePos;
+			return mTablePos == it.mTablePos && mCurrentCell == it.mCurrentCell;
+		}
+
+		/// Compares if two iterators are at different positions.
+		/// @param it The other iterator to check.
+		/// @return true if the iterators are at different positions, false
+		///  otherwise.
+		bool operator!=(const CIterator &it) const
+		{
+			return !(*this == it);
 		}
 
 		/// Dereferences the current element at the current iterator position.
@@ -209,41 +464,68 @@ public:
 		const KVPair& operator*() const
 		{
 			assert(mCurrentCell != nullptr);
+			return *mCurrentCell;
+		}
 
-			KVPair pair;
-			pair.key = mCurrentCell->key;
-			pair.value = mCurrentCell->value;
-			return pair;
+		/// Accesses the current element at the current iterator position.
+		/// @return The key/value pair of the dictionary at the current position.
+		const KVPair* operator->() const
+		{
+			assert(mCurrentCell != nullptr);
+			return mCurrentCell;
 		}
 	private:
-		Dictionary *mDictionary;
-		S32 mTablePos;
-		Cell *mCurrentCell;
+		const Dictionary *mDictionary;
+		size_t mTablePos;
+		const Cell *mCurrentCell;
+
+		/// Creates an iterator that points directly at a cell.
+		CIterator(const Dictionary *dictionary, size_t tablePos, const Cell *cell)
+		{
+			mDictionary = dictionary;
+			mTablePos = tablePos;
+			mCurrentCell = cell;
+		}
 
 		/// Advances the iterator to the next cell when it has to jump
-		/// to another bucket.
+		/// to another bucket. The current cell is nullptr at the end.
 		void findNextCell()
 		{
-			for (; mTablePos < mDictionary->mTableSize; ++mTablePos)
-			{
-				TableCell *cell = static_cast<TableCell*>(&mDictionary->mTable[mTablePos]);
-				if (cell->hasData)
-				{
-					mCurrentCell = static_cast<Cell*>(cell);
-					break;
-				}
-			}
+			mTablePos = mDictionary->nextOccupied(mTablePos);
+			if (mTablePos < mDictionary->tableEnd())
+				mCurrentCell = static_cast<const Cell*>(mDictionary->tableCellAt(mTablePos));
+			else
+				mCurrentCell = nullptr;
 		}
 	};
 
+	/// The result of an insertion. iterator points at the element with the
+	/// key, whether it was just inserted or was already there.
+	struct InsertResult
+	{
+		Iterator iterator;
+		bool inserted;
+	};
+
 public:
-	explicit Dictionary(S32 bucketSize)
+	/// Creates a Dictionary.
+	/// @param bucketSize The initial amount of buckets within the table. The
+	///  table will grow by itself once the load factor goes above the
+	///  maximum load factor. The bucket policy may round it up.
+	explicit Dictionary(S32 bucketSize = eDefaultBucketSize)
 	{
 		static_assert(!TypeTraits::IsSame<DictionaryKey, const char*>::value, "You cannot use const char* as a type for your dictionary key type! Please use String instead.");
 		static_assert(!TypeTraits::IsSame<DictionaryValue, const char*>::value, "You cannot use const char* as a type for your dictionary value type! Please use String instead.");
 
-		mTableSize = bucketSize;
-		mTable = static_cast<TableCell*>(calloc(bucketSize, sizeof(TableCell)));
+		mTableSize = BucketPolicy::roundBucketCount(static_cast<size_t>(mMax(bucketSize, 1)));
+		mBuckets.setBucketCount(mTableSize);
+		mTable = allocateTable(mTableSize);
+		mOldTable = nullptr;
+		mOldTableSize = 0;
+		mMigratePos = 0;
+		mMigrateStep = 0;
+		mCount = 0;
+		mMaxLoadFactor = 1.0f;
 	}
 
 	Dictionary(const Dictionary &) = delete;
@@ -251,17 +533,17 @@ public:
 
 	Dictionary(Dictionary &&dict)
 	{
-		mTableSize = dict.mTableSize;
-		mTable = dict.mTable;
+		takeTables(dict);
 		mPool = move_cast(dict.mPool);
-
-		dict.mTable = nullptr;
 	}
 
 	~Dictionary()
 	{
+		destroyCells();
 		free(mTable);
+		free(mOldTable);
 		mTable = nullptr;
+		mOldTable = nullptr;
 	}
 
 	Dictionary& operator=(Dictionary &&dict)
@@ -269,151 +551,624 @@ public:
 		if (this != &dict)
 		{
 			// Free old contents of the table
+			destroyCells();
 			free(mTable);
+			free(mOldTable);
 
-			mTableSize = dict.mTableSize;
-			mTable = dict.mTable;
+			takeTables(dict);
 			mPool = move_cast(dict.mPool);
-
-			dict.mTable = nullptr;
 		}
 		return *this;
 	}
 
-	DictionaryValue& operator[](const DictionaryKey &key)
+	/// Looks up the value for key, inserting a blank value if the key is not
+	/// within the dictionary yet.
+	/// @note An insertion may grow the table, which invalidates iterators.
+	DictionaryValue& operator[](const LookupKey &key)
 	{
-		// Yes, I know this isn't O(1), but its still faster than doing a linear search
-		// over the entire data set. If there's only 1 in the 'bucket' then it is O(1)
+		bool inserted;
+		size_t tablePos;
+		return findOrConstruct(hashKey(key), key, inserted, tablePos)->value;
+	}
 
-		size_t hash = hashWithTableSize(key);
-		for (Cell *kv = static_cast<Cell*>(&mTable[hash]); kv != nullptr; kv = kv->next)
+	/// Looks up the value for a key whose characters are already hashed,
+	/// inserting a blank value if the key is not within the dictionary yet.
+	/// Only the seed of the process is mixed in, the characters are never
+	/// hashed. Hash has to take a HashedKey, as HashFunction<String> does.
+	/// @note An insertion may grow the table, which invalidates iterators.
+	DictionaryValue& operator[](const HashedKey &key)
+	{
+		bool inserted;
+		size_t tablePos;
+		return findOrConstruct(hashKey(key), key.view(), inserted, tablePos)->value;
+	}
+
+	/// Looks up the value for a String key, inserting a blank value if the
+	/// key is not within the dictionary yet. A String that has cached its
+	/// hash is not hashed again. The cache of the key is never written.
+	/// @note An insertion may grow the table, which invalidates iterators.
+	template<typename K>
+	typename StoredKeyOverload<K, DictionaryValue&>::type operator[](const K &key)
+	{
+		bool inserted;
+		size_t tablePos;
+		return findOrConstruct(hashKey(key), key, inserted, tablePos)->value;
+	}
+
+	/// Inserts a key/value pair into the dictionary if the key is not within
+	/// the dictionary yet. An existing value is left untouched.
+	/// @return The position of the element with the key, and whether or not
+	///  it was inserted.
+	/// @note An insertion may grow the table, which invalidates iterators.
+	InsertResult insert(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		return emplace(key, value);
+	}
+
+	/// Inserts a key/value pair into the dictionary by moving them in if the
+	/// key is not within the dictionary yet. An existing value is left
+	/// untouched, and nothing is moved out of key or value in that case.
+	/// @return The position of the element with the key, and whether or not
+	///  it was inserted.
+	/// @note An insertion may grow the table, which invalidates iterators.
+	InsertResult insert(DictionaryKey &&key, DictionaryValue &&value)
+	{
+		return emplace(move_cast(key), move_cast(value));
+	}
+
+	/// Inserts a key/value pair into the dictionary if the key is not within
+	/// the dictionary yet, forwarding both into the stored element.
+	/// @return The position of the element with the key, and whether or not
+	///  it was inserted.
+	/// @note An insertion may grow the table, which invalidates iterators.
+	template<typename K, typename V>
+	InsertResult emplace(K &&key, V &&value)
+	{
+		return tryEmplace(static_cast<K&&>(key), static_cast<V&&>(value));
+	}
+
+	/// Inserts key with a value that is constructed in place from args, but
+	/// only if the key is not within the dictionary yet. If it is, nothing is
+	/// constructed and the arguments are left alone.
+	/// @return The position of the element with the key, and whether or not
+	///  it was inserted.
+	/// @note An insertion may grow the table, which invalidates iterators.
+	template<typename K, typename... Args>
+	InsertResult tryEmplace(K &&key, Args&&... args)
+	{
+		const size_t keyHash = hashKey(key);
+		return tryEmplaceWithHash(keyHash, static_cast<K&&>(key), static_cast<Args&&>(args)...);
+	}
+
+	/// Works like tryEmplace, but takes the hash of the key instead of
+	/// hashing it. This is for callers that need the hash for something
+	/// else as well, such as picking a shard, so that the key is only ever
+	/// hashed once.
+	/// @param keyHash What Hash gives for the key.
+	/// @note An insertion may grow the table, which invalidates iterators.
+	template<typename K, typename... Args>
+	InsertResult tryEmplaceWithHash(size_t keyHash, K &&key, Args&&... args)
+	{
+		bool inserted;
+		size_t tablePos;
+		Cell *cell = findOrConstruct(keyHash, static_cast<K&&>(key), inserted, tablePos, static_cast<Args&&>(args)...);
+		return InsertResult{Iterator(this, tablePos, cell), inserted};
+	}
+
+	/// Inserts a key/value pair into the dictionary, or assigns value to the
+	/// existing element if the key is already within the dictionary.
+	/// @return The position of the element with the key, and whether or not
+	///  it was inserted.
+	/// @note An insertion may grow the table, which invalidates iterators.
+	template<typename K, typename V>
+	InsertResult insertOrAssign(K &&key, V &&value)
+	{
+		const size_t keyHash = hashKey(key);
+		return insertOrAssignWithHash(keyHash, static_cast<K&&>(key), static_cast<V&&>(value));
+	}
+
+	/// Works like insertOrAssign, but takes the hash of the key instead of
+	/// hashing it.
+	/// @param keyHash What Hash gives for the key.
+	/// @see tryEmplaceWithHash
+	template<typename K, typename V>
+	InsertResult insertOrAssignWithHash(size_t keyHash, K &&key, V &&value)
+	{
+		bool inserted;
+		size_t tablePos;
+		Cell *cell = findOrConstruct(keyHash, static_cast<K&&>(key), inserted, tablePos, static_cast<V&&>(value));
+		if (!inserted)
+			cell->value = static_cast<V&&>(value);
+		return InsertResult{Iterator(this, tablePos, cell), inserted};
+	}
+
+	/// Looks up many keys at once. The keys are worked on in small groups:
+	/// every key of a group is hashed and its bucket is prefetched before
+	/// any of them is compared, so the cache misses of a group overlap
+	/// instead of being waited on one after another. This pays off when
+	/// the table is much larger than the cache.
+	/// @param keys The keys to look up.
+	/// @param n The amount of keys.
+	/// @param out Filled with a pointer to the value of every key, or nullptr
+	///  for keys that are not within the dictionary.
+	/// @return The amount of keys that were found.
+	/// @note This never moves buckets of an incremental rehash, as that
+	///  would move the values that were already handed out. The pointers
+	///  stay valid until the next call that inserts or moves buckets.
+	S32 findBatch(const DictionaryKey *keys, S32 n, DictionaryValue **out)
+	{
+		size_t hashes[eBatchGroupSize];
+		TableCell *buckets[eBatchGroupSize];
+		size_t tablePos;
+		S32 found = 0;
+
+		for (S32 groupStart = 0; groupStart < n; groupStart += eBatchGroupSize)
 		{
-			if (equals(key, kv->key))
-				return kv->value;
+			const S32 groupSize = mMin(n - groupStart, static_cast<S32>(eBatchGroupSize));
+			const DictionaryKey *groupKeys = keys + groupStart;
+
+			for (S32 i = 0; i < groupSize; ++i)
+			{
+				hashes[i] = hashKey(groupKeys[i]);
+				buckets[i] = bucketFor(hashes[i], tablePos);
+				PREFETCH(buckets[i]);
+			}
+
+			for (S32 i = 0; i < groupSize; ++i)
+			{
+				Cell *cell = findCell(buckets[i], hashes[i], groupKeys[i]);
+				out[groupStart + i] = cell != nullptr ? &cell->value : nullptr;
+				if (cell != nullptr)
+					++found;
+			}
 		}
+		return found;
+	}
+
+	/// Inserts many key/value pairs at once. Keys that are already within
+	/// the dictionary keep their value, the same as insert. The table is
+	/// grown once per group up front, and then the buckets of the group are
+	/// prefetched together like findBatch does.
+	/// @param keys The keys to insert.
+	/// @param values The values to insert, one for every key.
+	/// @param n The amount of pairs.
+	/// @return The amount of pairs that were inserted.
+	/// @note An insertion may grow the table, which invalidates iterators.
+	S32 insertBatch(const DictionaryKey *keys, const DictionaryValue *values, S32 n)
+	{
+		size_t hashes[eBatchGroupSize];
+		TableCell *buckets[eBatchGroupSize];
+		size_t tablePos;
+		S32 inserted = 0;
 
-		// Perform an insertion of the key with blank value
+		for (S32 groupStart = 0; groupStart < n; groupStart += eBatchGroupSize)
 		{
-			TableCell *tableCell = &mTable[hash];
+			const S32 groupSize = mMin(n - groupStart, static_cast<S32>(eBatchGroupSize));
+			const DictionaryKey *groupKeys = keys + groupStart;
+			const DictionaryValue *groupValues = values + groupStart;
+			migrateStep();
 
-			// first cell is always a TableCell not a Cell.
-			if (!tableCell->hasData)
+			// Make room for the whole group first, so that the buckets
+			// do not move while the group is being inserted.
+			growIfNeeded(static_cast<size_t>(groupSize));
+
+			for (S32 i = 0; i < groupSize; ++i)
 			{
-				// First data hasn't been filled in.
-				tableCell->key = key;
-				tableCell->hasData = true;
-				return tableCell->value;
+				hashes[i] = hashKey(groupKeys[i]);
+				buckets[i] = bucketFor(hashes[i], tablePos);
+				PREFETCH(buckets[i]);
 			}
-			else
+
+			for (S32 i = 0; i < groupSize; ++i)
 			{
-				// Linked list chain.
-				Cell *cell = static_cast<Cell*>(tableCell);
-				while (cell->next != nullptr)
-					cell = cell->next;
-
-				// Create next cell for next insert.
-				Cell *newCell = mPool.alloc(1);
-				newCell->key = key;
-				newCell->previous = cell;
-
-				cell->next = newCell;
-				return newCell->value;
+				if (findCell(buckets[i], hashes[i], groupKeys[i]) == nullptr)
+				{
+					constructCell(buckets[i], hashes[i], groupKeys[i], groupValues[i]);
+					++inserted;
+				}
 			}
 		}
+		return inserted;
 	}
 
-	void insert(const DictionaryKey &key, const DictionaryValue &value)
+	/// Replaces the contents of the dictionary with pairs, using threadCount
+	/// threads. If a key is in pairs more than once, the first pair wins,
+	/// the same as inserting the pairs one by one would.
+	///
+	/// The table is sized for every pair up front and split into one range
+	/// of buckets per thread. The threads hash their share of the pairs and
+	/// sort them by range, then every thread fills its own range. No two
+	/// threads ever touch the same bucket, so there are no locks, and every
+	/// thread takes chained cells from its own pool, which is handed over to
+	/// the dictionary at the end.
+	/// @param pairs The pairs to build the dictionary from.
+	/// @param threadCount The amount of threads to use, including the calling
+	///  thread. Small inputs use fewer.
+	void buildParallel(const Vector<KVPair> &pairs, S32 threadCount)
 	{
-		size_t hash = hashWithTableSize(key);
-		TableCell *tableCell = &mTable[hash];
+		clear();
+		const S32 count = pairs.count();
+		if (count == 0)
+			return;
 
-		// first cell is always a TableCell not a Cell.
-		if (!tableCell->hasData)
+		reserve(count);
+		threadCount = mMax(mMin(threadCount, count / eMinParallelBuildPairs), 1);
+
+		BuildJob job;
+		job.dictionary = this;
+		job.pairs = &pairs[0];
+		job.pairCount = count;
+		job.threadCount = threadCount;
+		job.hashes = static_cast<size_t*>(malloc(sizeof(size_t) * count));
+		job.order = static_cast<S32*>(malloc(sizeof(S32) * count));
+		job.offsets = static_cast<S32*>(calloc(static_cast<size_t>(threadCount) * threadCount + threadCount + 1, sizeof(S32)));
+		job.rangeStarts = job.offsets + threadCount * threadCount;
+
+		BuildTask *tasks = new BuildTask[threadCount];
+		for (S32 i = 0; i < threadCount; ++i)
 		{
-			// First data hasn't been filled in.
-			tableCell->key = key;
-			tableCell->value = value;
-			tableCell->hasData = true;
+			tasks[i].job = &job;
+			tasks[i].index = i;
+			tasks[i].inserted = 0;
 		}
-		else
+
+		// Count how many pairs of every slice go to every range, then turn
+		// the counts into the position each slice writes its first pair of
+		// each range to. Ranges are laid out one after the other, and within
+		// a range the slices are in order, so pairs stay in input order.
+		runOnThreads(tasks, sizeof(BuildTask), threadCount, &Dictionary::hashSlice);
+		S32 position = 0;
+		for (S32 range = 0; range < threadCount; ++range)
 		{
-			// Linked list chain.
-			Cell *cell = static_cast<Cell*>(tableCell);
-			while (cell->next != nullptr)
-				cell = cell->next;
-			
-			// Create next cell for next insert.
-			Cell *newCell = mPool.alloc(1);
-			newCell->key = key;
-			newCell->value = value;
-			newCell->previous = cell;
+			job.rangeStarts[range] = position;
+			for (S32 slice = 0; slice < threadCount; ++slice)
+			{
+				S32 &offset = job.offsets[slice * threadCount + range];
+				const S32 sliceCount = offset;
+				offset = position;
+				position += sliceCount;
+			}
+		}
+		job.rangeStarts[threadCount] = position;
+
+		runOnThreads(tasks, sizeof(BuildTask), threadCount, &Dictionary::sortSlice);
+		runOnThreads(tasks, sizeof(BuildTask), threadCount, &Dictionary::fillRange);
 
-			cell->next = newCell;
+		for (S32 i = 0; i < threadCount; ++i)
+		{
+			mCount += tasks[i].inserted;
+			mPool.absorb(tasks[i].pool);
 		}
+
+		delete[] tasks;
+		free(job.offsets);
+		free(job.order);
+		free(job.hashes);
 	}
 
-	Iterator find(const DictionaryKey &key)
+	/// Removes every element from the dictionary. The table keeps its size
+	/// and the memory of the cell pool is kept around for reuse.
+	void clear()
 	{
-		size_t hash = hashWithTableSize(key);
-		for (Iterator iter = Iterator(this, hash); iter != end(); ++iter)
+		destroyCells();
+		endMigration();
+
+		if (mTable != nullptr)
 		{
-			if (equals((*iter).key, key))
-				return iter;
+			memset(static_cast<void*>(mTable), 0, tableBytes(mTableSize));
 		}
-		return end();
+		else
+		{
+			// A dictionary that was moved from has no table. Give it an
+			// empty one, so that it can be used again.
+			mTableSize = BucketPolicy::roundBucketCount(static_cast<size_t>(eDefaultBucketSize));
+			mBuckets.setBucketCount(mTableSize);
+			mTable = allocateTable(mTableSize);
+		}
+		mPool.reset();
+		mCount = 0;
+	}
+
+	/// Makes sure that the dictionary can hold at least count elements
+	/// without going over the maximum load factor.
+	/// @param count The amount of elements to make room for.
+	void reserve(S32 count)
+	{
+		size_t buckets = bucketCountFor(static_cast<size_t>(mMax(count, 0)));
+		if (buckets > mTableSize)
+			rehash(buckets);
+	}
+
+	/// Shrinks the table down to the smallest amount of buckets that can
+	/// hold the current elements without going over the maximum load factor.
+	void shrinkToFit()
+	{
+		size_t buckets = bucketCountFor(mCount);
+		if (buckets < mTableSize)
+			rehash(buckets);
+	}
+
+	/// Gets the amount of elements within the dictionary.
+	/// @return The amount of elements in the dictionary.
+	FORCE_INLINE S32 count() const
+	{
+		return static_cast<S32>(mCount);
+	}
+
+	/// Gets the amount of buckets within the table.
+	/// @return The amount of buckets in the table.
+	FORCE_INLINE S32 bucketCount() const
+	{
+		return static_cast<S32>(mTableSize);
+	}
+
+	/// Gets the size of the memory block that a table is allocated in. The
+	/// occupancy bitmap follows the buckets within the same block.
+	/// @param tableSize The amount of buckets in the table.
+	/// @return The size of the block in bytes.
+	static FORCE_INLINE size_t tableBytes(size_t tableSize)
+	{
+		return tableSize * sizeof(TableCell) + occupancyWords(tableSize) * sizeof(U64);
+	}
+
+	/// Gets the average amount of elements per bucket.
+	/// @return The current load factor.
+	FORCE_INLINE F32 loadFactor() const
+	{
+		return static_cast<F32>(mCount) / static_cast<F32>(mTableSize);
+	}
+
+	/// Gets the load factor at which the table grows.
+	/// @return The maximum load factor.
+	FORCE_INLINE F32 maxLoadFactor() const
+	{
+		return mMaxLoadFactor;
+	}
+
+	/// Sets the load factor at which the table grows. If the dictionary
+	/// is already above it, the table grows right away.
+	/// @param loadFactor The maximum average amount of elements per bucket.
+	void setMaxLoadFactor(F32 loadFactor)
+	{
+		assert(loadFactor > 0.0f);
+		mMaxLoadFactor = loadFactor;
+
+		size_t buckets = bucketCountFor(mCount);
+		if (buckets > mTableSize)
+			rehash(buckets);
+	}
+
+	/// Turns incremental rehashing on or off.
+	///
+	/// When it is on, growing the table no longer moves every element at
+	/// once. The old and the new table are kept alive together, and every
+	/// call to operator[], insert or find moves over a few buckets until the
+	/// old table is empty. This spreads the cost of a rehash over many
+	/// calls at the price of holding both tables in memory for a while.
+	///
+	/// @param enabled true to rehash incrementally, false to rehash all at once.
+	/// @param bucketsPerStep The amount of old buckets to move on every call.
+	/// @note A call that moves buckets invalidates iterators, the same way
+	///  that an insertion does. Iterating and erasing on their own never move
+	///  buckets.
+	void setIncrementalRehash(bool enabled, S32 bucketsPerStep = eDefaultMigrateStep)
+	{
+		assert(!enabled || bucketsPerStep > 0);
+		if (!enabled)
+			finishMigration();
+		mMigrateStep = enabled ? static_cast<size_t>(bucketsPerStep) : 0;
+	}
+
+	/// Checks to see if an incremental rehash is still moving buckets over.
+	/// @return true if the old table is still alive, false otherwise.
+	FORCE_INLINE bool isRehashing() const
+	{
+		return mOldTable != nullptr;
+	}
+
+	/// Checks to see if the dictionary contains key.
+	/// @param key The key to look for.
+	/// @return true if the key is within the dictionary, false otherwise.
+	bool contains(const LookupKey &key) const
+	{
+		size_t tablePos;
+		const size_t keyHash = hashKey(key);
+		return findCell(bucketFor(keyHash, tablePos), keyHash, key) != nullptr;
 	}
 
-	CIterator find(const DictionaryKey &key) const
+	/// Walks over every bucket to gather how well the keys are spread and
+	/// how much memory the dictionary takes up. This is O(n), so it is meant
+	/// for metrics and debugging, not for hot paths.
+	/// @return The stats of the dictionary.
+	DictionaryStats stats() const
 	{
-		size_t hash = hashWithTableSize(key);
-		for (CIterator iter = CIterator(this, hash); iter != end(); ++iter)
+		DictionaryStats result;
+		memset(&result, 0, sizeof(result));
+
+		const size_t tableEnd = this->tableEnd();
+		size_t probes = 0;
+		for (size_t i = 0; i < tableEnd; ++i)
 		{
-			if (equals((*iter).key, key))
-				return iter;
+			const TableCell *tableCell = tableCellAt(i);
+			S32 length = 0;
+			if (tableCell->hasData)
+			{
+				for (const Cell *cell = tableCell; cell != nullptr; cell = cell->next)
+					++length;
+			}
+
+			// Finding the n-th key of a chain compares against n keys.
+			probes += static_cast<size_t>(length) * static_cast<size_t>(length + 1) / 2;
+			if (length != 0)
+				++result.usedBuckets;
+			result.maxChainLength = mMax(result.maxChainLength, length);
+			++result.chainHistogram[mMin(length, static_cast<S32>(DictionaryStats::eChainHistogramSize - 1))];
 		}
+
+		result.count = count();
+		result.bucketCount = static_cast<S32>(tableEnd);
+		result.loadFactor = loadFactor();
+		result.averageProbeLength = mCount != 0 ? static_cast<F32>(probes) / static_cast<F32>(mCount) : 0.0f;
+		result.tableBytes = tableBytes(mTableSize) + (mOldTable != nullptr ? tableBytes(mOldTableSize) : 0);
+		result.poolBytes = mPool.getAllocatedBytes();
+		result.poolPages = mPool.getPageCount();
+		result.chainedCells = result.count - result.usedBuckets;
+		result.freeCells = mPool.getFreeCount();
+		result.rehashing = isRehashing();
+		return result;
+	}
+
+	/// Gets the amount of memory pages used for chained cells. Erased cells
+	/// are reused, so this only grows with the peak amount of elements.
+	/// @return The amount of pages within the cell pool.
+	FORCE_INLINE S32 poolPageCount() const
+	{
+		return mPool.getPageCount();
+	}
+
+	Iterator find(const LookupKey &key)
+	{
+		return findWithHash(key, hashKey(key));
+	}
+
+	CIterator find(const LookupKey &key) const
+	{
+		return findWithHash(key, hashKey(key));
+	}
+
+	/// Looks up a key whose characters are already hashed. Only the seed of
+	/// the process is mixed in, the characters are never hashed. Hash has to
+	/// take a HashedKey, as HashFunction<String> does.
+	Iterator find(const HashedKey &key)
+	{
+		return findWithHash(key.view(), hashKey(key));
+	}
+
+	CIterator find(const HashedKey &key) const
+	{
+		return findWithHash(key.view(), hashKey(key));
+	}
+
+	/// Checks to see if the dictionary contains a key whose characters are
+	/// already hashed.
+	/// @see find(const HashedKey &)
+	bool contains(const HashedKey &key) const
+	{
+		size_t tablePos;
+		const size_t keyHash = hashKey(key);
+		return findCell(bucketFor(keyHash, tablePos), keyHash, key.view()) != nullptr;
+	}
+
+	/// Works like find, but takes the hash of the key instead of hashing it.
+	/// @param keyHash What Hash gives for the key.
+	/// @see tryEmplaceWithHash
+	Iterator findWithHash(const LookupKey &key, size_t keyHash)
+	{
+		migrateStep();
+
+		size_t tablePos;
+		Cell *cell = findCell(bucketFor(keyHash, tablePos), keyHash, key);
+		if (cell != nullptr)
+			return Iterator(this, tablePos, cell);
 		return end();
 	}
 
-	Iterator erase(Iterator iterator)
+	CIterator findWithHash(const LookupKey &key, size_t keyHash) const
 	{
-		// Note: Erase doesn't actually 'free' the memory block of
-		// the cell. It just removes the pointer and leaves it dangling.
-		// The memory will be reclaimed once the dictionary is destroyed.
+		size_t tablePos;
+		const Cell *cell = findCell(bucketFor(keyHash, tablePos), keyHash, key);
+		if (cell != nullptr)
+			return CIterator(this, tablePos, cell);
+		return end();
+	}
 
+	/// Works like contains, but takes the hash of the key instead of hashing
+	/// it.
+	/// @param keyHash What Hash gives for the key.
+	/// @see tryEmplaceWithHash
+	bool containsWithHash(const LookupKey &key, size_t keyHash) const
+	{
+		size_t tablePos;
+		return findCell(bucketFor(keyHash, tablePos), keyHash, key) != nullptr;
+	}
+
+	/// Looks up a String key by the hash that it has cached, if any.
+	/// @see operator[](const K &)
+	template<typename K>
+	typename StoredKeyOverload<K, Iterator>::type find(const K &key)
+	{
+		return findWithHash(key, hashKey(key));
+	}
+
+	template<typename K>
+	typename StoredKeyOverload<K, CIterator>::type find(const K &key) const
+	{
+		return findWithHash(key, hashKey(key));
+	}
+
+	/// Checks to see if the dictionary contains a String key, by the hash
+	/// that it has cached, if any.
+	/// @see operator[](const K &)
+	template<typename K>
+	typename StoredKeyOverload<K, bool>::type contains(const K &key) const
+	{
+		size_t tablePos;
+		const size_t keyHash = hashKey(key);
+		return findCell(bucketFor(keyHash, tablePos), keyHash, key) != nullptr;
+	}
+
+	/// Erases the element at the iterator position.
+	/// @param iterator The position of the element to erase.
+	/// @return An iterator to the element following the erased element.
+	Iterator erase(Iterator iterator)
+	{
 		Cell *currentCell = iterator.mCurrentCell;
 		Cell *nextCell = currentCell->next;
 		Cell *previousCell = currentCell->previous;
+		--mCount;
 
 		if (previousCell == nullptr)
 		{
 			// This means that currentCell is a table cell.
+			TableCell *tableCell = static_cast<TableCell*>(currentCell);
+			currentCell->~Cell();
 
 			if (nextCell == nullptr)
 			{
 				// No next cell, we were the only cell in the table slot.
-				// mark it as empty...
-				static_cast<TableCell*>(currentCell)->hasData = false;
+				// mark it as empty and move on to the next bucket.
+				setOccupied(tableCell, false);
+				iterator.mTablePos++;
+				iterator.findNextCell();
 			}
 			else
 			{
-				// Go ahead and move nextCell into currentCell.
-				currentCell->key = nextCell->key;
-				currentCell->value = nextCell->value;
+				// Go ahead and move nextCell into currentCell and give the
+				// memory of nextCell back to the pool. The iterator now
+				// points at what used to be the next cell.
+				new (currentCell) Cell(nextCell->hash, move_cast(nextCell->key), move_cast(nextCell->value));
 				currentCell->next = nextCell->next;
-				currentCell->previous = nullptr;
-				static_cast<TableCell*>(currentCell)->hasData = true;
+				if (currentCell->next != nullptr)
+					currentCell->next->previous = currentCell;
+				mPool.destroy(nextCell);
 			}
 		}
 		else
 		{
-			if (nextCell == nullptr)
-				previousCell->next = nullptr;
+			previousCell->next = nextCell;
+			if (nextCell != nullptr)
+			{
+				nextCell->previous = previousCell;
+				iterator.mCurrentCell = nextCell;
+			}
 			else
-				previousCell->next = nextCell;
+			{
+				iterator.mTablePos++;
+				iterator.findNextCell();
+			}
+			mPool.destroy(currentCell);
 		}
-		
-		// Iterator has already been accounted for since it internally
-		// uses our current thisptr for looping.
+
 		return iterator;
 	}
 
@@ -428,7 +1183,7 @@ public:
 	/// @return an iterator at the end of the Dictionary.
 	FORCE_INLINE Iterator end()
 	{
-		return Iterator(this, mTableSize);
+		return Iterator(this, tableEnd());
 	}
 
 	/// Grabs a constant iterator at the beginning of the Dictionary.
@@ -442,13 +1197,530 @@ public:
 	/// @return a constant iterator at the end of the Dictionary.
 	FORCE_INLINE CIterator end() const
 	{
-		return CIterator(this, mTableSize);
+		return CIterator(this, tableEnd());
 	}
 
 private:
 	TableCell* mTable;
 	size_t mTableSize;
+	BucketPolicy mBuckets;
+
+	/// The table that is being emptied by an incremental rehash, or nullptr.
+	/// Buckets below mMigratePos have already been moved into mTable.
+	TableCell* mOldTable;
+	size_t mOldTableSize;
+	BucketPolicy mOldBuckets;
+	size_t mMigratePos;
+
+	/// Amount of old buckets moved per call, or 0 to rehash all at once.
+	size_t mMigrateStep;
+
+	size_t mCount;
+	F32 mMaxLoadFactor;
 	MemoryChunker<Cell> mPool;
+
+	/// Iterators walk over the old table first and then over the new table,
+	/// as one range of table positions.
+	FORCE_INLINE size_t tableEnd() const
+	{
+		return mOldTableSize + mTableSize;
+	}
+
+	FORCE_INLINE TableCell* tableCellAt(size_t tablePos) const
+	{
+		if (tablePos < mOldTableSize)
+			return &mOldTable[tablePos];
+		return &mTable[tablePos - mOldTableSize];
+	}
+
+	static FORCE_INLINE size_t occupancyWords(size_t tableSize)
+	{
+		return (tableSize + 63) / 64;
+	}
+
+	static FORCE_INLINE U64* occupancyOf(TableCell *table, size_t tableSize)
+	{
+		return reinterpret_cast<U64*>(table + tableSize);
+	}
+
+	/// Allocates a zeroed table of tableSize buckets with its bitmap.
+	static TableCell* allocateTable(size_t tableSize)
+	{
+		static_assert(sizeof(TableCell) % sizeof(U64) == 0, "The occupancy bitmap has to be aligned after the table.");
+		return static_cast<TableCell*>(calloc(1, tableBytes(tableSize)));
+	}
+
+	/// Sets hasData of a bucket of either table, and its occupancy bit.
+	FORCE_INLINE void setOccupied(TableCell *tableCell, bool occupied)
+	{
+		TableCell *table = mTable;
+		size_t tableSize = mTableSize;
+		if (mOldTable != nullptr && tableCell >= mOldTable && tableCell < mOldTable + mOldTableSize)
+		{
+			table = mOldTable;
+			tableSize = mOldTableSize;
+		}
+
+		const size_t bucket = static_cast<size_t>(tableCell - table);
+		U64 &word = occupancyOf(table, tableSize)[bucket / 64];
+		const U64 bit = static_cast<U64>(1) << (bucket % 64);
+		word = occupied ? (word | bit) : (word & ~bit);
+		tableCell->hasData = occupied;
+	}
+
+	/// Finds the first occupied bucket at or after bucket within one table.
+	/// @return Its bucket, or tableSize if there is none.
+	static size_t scanOccupancy(TableCell *table, size_t tableSize, size_t bucket)
+	{
+		if (bucket >= tableSize)
+			return tableSize;
+
+		const U64 *bits = occupancyOf(table, tableSize);
+		const size_t words = occupancyWords(tableSize);
+		size_t word = bucket / 64;
+		U64 mask = bits[word] & (~static_cast<U64>(0) << (bucket % 64));
+		while (mask == 0)
+		{
+			if (++word == words)
+				return tableSize;
+			mask = bits[word];
+		}
+		return word * 64 + countTrailingZeros(mask);
+	}
+
+	/// Finds the first table position at or after tablePos whose bucket
+	/// holds an element, over the old table first and then the new one.
+	/// @return The table position, or tableEnd() if there is none.
+	size_t nextOccupied(size_t tablePos) const
+	{
+		if (tablePos < mOldTableSize)
+		{
+			const size_t bucket = scanOccupancy(mOldTable, mOldTableSize, tablePos);
+			if (bucket < mOldTableSize)
+				return bucket;
+			tablePos = mOldTableSize;
+		}
+		return mOldTableSize + scanOccupancy(mTable, mTableSize, tablePos - mOldTableSize);
+	}
+
+	FORCE_INLINE size_t hashKey(const LookupKey &key) const
+	{
+		Hash hash;
+		return hash(key);
+	}
+
+	FORCE_INLINE size_t hashKey(const HashedKey &key) const
+	{
+		Hash hash;
+		return hash(key);
+	}
+
+	/// Hashes a stored String key whole, which reads the hash that it has
+	/// cached, if any. Lookups only ever take keys as const, so they never
+	/// write the cache of a key that other threads may be hashing.
+	template<typename K>
+	FORCE_INLINE typename StoredKeyOverload<K, size_t>::type hashKey(const K &key) const
+	{
+		Hash hash;
+		return hash(key);
+	}
+
+	/// Hashes a String key that an insertion was handed as changeable, and
+	/// caches its text hash. The key that is moved or copied into the table
+	/// then carries the cache along.
+	template<typename K>
+	FORCE_INLINE typename StoredKeyOverload<K, size_t>::type hashKey(K &key) const
+	{
+		Hash hash;
+		return hash(key);
+	}
+
+	/// Finds the bucket that a key with the hash keyHash belongs in. While
+	/// an incremental rehash is running, keys whose old bucket has not been
+	/// moved yet still live in the old table, so every key has exactly one
+	/// place it can be.
+	/// @param tablePos Filled with the iterator position of the bucket.
+	TableCell* bucketFor(size_t keyHash, size_t &tablePos) const
+	{
+		if (mOldTable != nullptr)
+		{
+			const size_t oldBucket = mOldBuckets.bucketIndex(keyHash);
+			if (oldBucket >= mMigratePos)
+			{
+				tablePos = oldBucket;
+				return &mOldTable[oldBucket];
+			}
+		}
+
+		const size_t bucket = mBuckets.bucketIndex(keyHash);
+		tablePos = mOldTableSize + bucket;
+		return &mTable[bucket];
+	}
+
+	/// Finds the cell within bucket that holds key. Keys are only compared
+	/// for cells whose stored hash matches keyHash.
+	/// @return The cell, or nullptr if key is not within the bucket.
+	Cell* findCell(TableCell *bucket, size_t keyHash, const LookupKey &key) const
+	{
+		// Yes, I know this isn't O(1), but its still faster than doing a linear search
+		// over the entire data set. If there's only 1 in the 'bucket' then it is O(1)
+		if (!bucket->hasData)
+			return nullptr;
+
+		for (Cell *kv = static_cast<Cell*>(bucket); kv != nullptr; kv = kv->next)
+		{
+			if (kv->hash == keyHash && equals(key, kv->key))
+				return kv;
+		}
+		return nullptr;
+	}
+
+	/// Finds the cell that holds key, or constructs one from key and args if
+	/// there is none. The key is only hashed once, even if the table has to
+	/// grow in between.
+	/// @param keyHash The hash of key.
+	/// @param inserted Set to true if a new cell was constructed.
+	/// @param tablePos Filled with the iterator position of the cell's bucket.
+	template<typename K, typename... Args>
+	Cell* findOrConstruct(size_t keyHash, K &&key, bool &inserted, size_t &tablePos, Args&&... args)
+	{
+		migrateStep();
+
+		{
+			// Only look at key through a LookupKey, as key might get moved
+			// into the new cell afterwards.
+			const LookupKey &lookup = key;
+			Cell *cell = findCell(bucketFor(keyHash, tablePos), keyHash, lookup);
+			if (cell != nullptr)
+			{
+				inserted = false;
+				return cell;
+			}
+		}
+
+		growIfNeeded();
+
+		inserted = true;
+		return constructCell(bucketFor(keyHash, tablePos), keyHash, static_cast<K&&>(key), static_cast<Args&&>(args)...);
+	}
+
+	void takeTables(Dictionary &dict)
+	{
+		mTable = dict.mTable;
+		mTableSize = dict.mTableSize;
+		mBuckets = dict.mBuckets;
+		mOldTable = dict.mOldTable;
+		mOldTableSize = dict.mOldTableSize;
+		mOldBuckets = dict.mOldBuckets;
+		mMigratePos = dict.mMigratePos;
+		mMigrateStep = dict.mMigrateStep;
+		mCount = dict.mCount;
+		mMaxLoadFactor = dict.mMaxLoadFactor;
+
+		dict.mTable = nullptr;
+		dict.mTableSize = 0;
+		dict.mOldTable = nullptr;
+		dict.mOldTableSize = 0;
+		dict.mCount = 0;
+	}
+
+	/// Calculates the amount of buckets needed to hold count elements
+	/// without going over the maximum load factor, as the bucket policy
+	/// allows it.
+	size_t bucketCountFor(size_t count) const
+	{
+		size_t buckets = static_cast<size_t>(static_cast<F32>(count) / mMaxLoadFactor);
+		if (static_cast<F32>(buckets) * mMaxLoadFactor < static_cast<F32>(count))
+			++buckets;
+		return BucketPolicy::roundBucketCount(buckets);
+	}
+
+	/// Doubles the size of the table if inserting extra more elements would
+	/// put it over the maximum load factor.
+	/// @return true if the table was rehashed, false otherwise.
+	bool growIfNeeded(size_t extra = 1)
+	{
+		if (static_cast<F32>(mCount + extra) <= static_cast<F32>(mTableSize) * mMaxLoadFactor)
+			return false;
+
+		const size_t buckets = mMax(mTableSize * 2, bucketCountFor(mCount + extra));
+		if (mMigrateStep == 0)
+		{
+			rehash(buckets);
+		}
+		else
+		{
+			// Only one migration can be in flight at a time.
+			finishMigration();
+			mOldTable = mTable;
+			mOldTableSize = mTableSize;
+			mOldBuckets = mBuckets;
+			mMigratePos = 0;
+
+			mTableSize = buckets;
+			mBuckets.setBucketCount(mTableSize);
+			mTable = allocateTable(mTableSize);
+		}
+		return true;
+	}
+
+	/// Constructs a new element within the bucket and counts it. The first
+	/// element of a bucket lives inside of the table itself, the rest are
+	/// taken from the pool and chained right after it.
+	template<typename... Args>
+	Cell* constructCell(TableCell *tableCell, size_t keyHash, Args&&... args)
+	{
+		++mCount;
+
+		if (!tableCell->hasData)
+		{
+			new (static_cast<Cell*>(tableCell)) Cell(keyHash, static_cast<Args&&>(args)...);
+			setOccupied(tableCell, true);
+			return static_cast<Cell*>(tableCell);
+		}
+
+		Cell *newCell = mPool.construct(keyHash, static_cast<Args&&>(args)...);
+		linkAfterTableCell(tableCell, newCell);
+		return newCell;
+	}
+
+	/// Runs the destructor of every element. The memory itself is left
+	/// alone, it belongs to the tables and the pool.
+	void destroyCells()
+	{
+		if (TypeTraits::IsTriviallyDestructible<DictionaryKey>::value && TypeTraits::IsTriviallyDestructible<DictionaryValue>::value)
+			return;
+
+		const size_t tableEnd = this->tableEnd();
+		for (size_t i = nextOccupied(0); i < tableEnd; i = nextOccupied(i + 1))
+		{
+			TableCell *tableCell = tableCellAt(i);
+			Cell *cell = tableCell->next;
+			while (cell != nullptr)
+			{
+				Cell *next = cell->next;
+				cell->~Cell();
+				cell = next;
+			}
+			static_cast<Cell*>(tableCell)->~Cell();
+		}
+	}
+
+	/// Moves up to mMigrateStep buckets from the old table into the new
+	/// table. Empty buckets are cheap to skip, so a few more of them are
+	/// allowed per step.
+	void migrateStep()
+	{
+		if (mOldTable == nullptr)
+			return;
+
+		size_t moved = 0;
+		size_t emptyVisits = mMigrateStep * 10;
+		while (mMigratePos < mOldTableSize && moved < mMigrateStep)
+		{
+			TableCell *oldCell = &mOldTable[mMigratePos++];
+			if (oldCell->hasData)
+			{
+				moveBucket(oldCell);
+				++moved;
+			}
+			else if (--emptyVisits == 0)
+			{
+				break;
+			}
+		}
+
+		if (mMigratePos == mOldTableSize)
+			endMigration();
+	}
+
+	/// Moves every bucket that is still in the old table over.
+	void finishMigration()
+	{
+		if (mOldTable == nullptr)
+			return;
+
+		for (; mMigratePos < mOldTableSize; ++mMigratePos)
+		{
+			TableCell *oldCell = &mOldTable[mMigratePos];
+			if (oldCell->hasData)
+				moveBucket(oldCell);
+		}
+		endMigration();
+	}
+
+	void endMigration()
+	{
+		free(mOldTable);
+		mOldTable = nullptr;
+		mOldTableSize = 0;
+		mMigratePos = 0;
+	}
+
+	/// Rebuilds the table with a new amount of buckets all at once.
+	void rehash(size_t bucketCount)
+	{
+		finishMigration();
+
+		TableCell *oldTable = mTable;
+		size_t oldTableSize = mTableSize;
+
+		mTableSize = bucketCount;
+		mBuckets.setBucketCount(mTableSize);
+		mTable = allocateTable(mTableSize);
+
+		for (size_t i = 0; i < oldTableSize; ++i)
+		{
+			TableCell *oldCell = &oldTable[i];
+			if (oldCell->hasData)
+				moveBucket(oldCell);
+		}
+
+		free(oldTable);
+	}
+
+	/// Moves every element of an old bucket into mTable. Chained cells are
+	/// relinked into their new bucket, only the element that lives inside of
+	/// the old table itself has to be moved. The new buckets come from the
+	/// stored hashes, so no key is hashed again.
+	void moveBucket(TableCell *oldCell)
+	{
+		Cell *cell = oldCell->next;
+		while (cell != nullptr)
+		{
+			Cell *next = cell->next;
+			relinkCell(cell);
+			cell = next;
+		}
+
+		TableCell *tableCell = &mTable[mBuckets.bucketIndex(oldCell->hash)];
+		if (!tableCell->hasData)
+		{
+			new (static_cast<Cell*>(tableCell)) Cell(oldCell->hash, move_cast(oldCell->key), move_cast(oldCell->value));
+			setOccupied(tableCell, true);
+		}
+		else
+		{
+			Cell *newCell = mPool.construct(oldCell->hash, move_cast(oldCell->key), move_cast(oldCell->value));
+			linkAfterTableCell(tableCell, newCell);
+		}
+
+		static_cast<Cell*>(oldCell)->~Cell();
+		oldCell->next = nullptr;
+
+		// Only the old table of an incremental rehash is still iterated
+		// over, rehash() frees its old table right away.
+		if (mOldTable != nullptr)
+			setOccupied(oldCell, false);
+		else
+			oldCell->hasData = false;
+	}
+
+	/// Moves a chained cell over to its bucket within the new table.
+	void relinkCell(Cell *cell)
+	{
+		TableCell *tableCell = &mTable[mBuckets.bucketIndex(cell->hash)];
+		if (!tableCell->hasData)
+		{
+			// The element moves into the table, so the chained cell can go
+			// back to the pool.
+			new (static_cast<Cell*>(tableCell)) Cell(cell->hash, move_cast(cell->key), move_cast(cell->value));
+			setOccupied(tableCell, true);
+			mPool.destroy(cell);
+		}
+		else
+		{
+			linkAfterTableCell(tableCell, cell);
+		}
+	}
+
+	/// The range of buckets that a bucket belongs to. Ranges are made of
+	/// whole words of the occupancy bitmap, so that no two threads ever
+	/// write to the same word.
+	static FORCE_INLINE S32 rangeOf(size_t bucket, size_t tableSize, S32 rangeCount)
+	{
+		return static_cast<S32>(static_cast<U64>(bucket / 64) * static_cast<U64>(rangeCount) / occupancyWords(tableSize));
+	}
+
+	/// Hashes the slice of pairs of a task and counts how many of them go to
+	/// every range.
+	static void hashSlice(void *arg)
+	{
+		BuildTask *task = static_cast<BuildTask*>(arg);
+		BuildJob *job = task->job;
+		const Dictionary *dictionary = job->dictionary;
+		S32 *counts = job->offsets + task->index * job->threadCount;
+
+		const S32 end = sliceStart(job, task->index + 1);
+		for (S32 i = sliceStart(job, task->index); i < end; ++i)
+		{
+			const size_t keyHash = dictionary->hashKey(job->pairs[i].key);
+			job->hashes[i] = keyHash;
+			++counts[rangeOf(dictionary->mBuckets.bucketIndex(keyHash), dictionary->mTableSize, job->threadCount)];
+		}
+	}
+
+	/// Writes the positions of the slice of pairs of a task into order, at
+	/// the place of their range.
+	static void sortSlice(void *arg)
+	{
+		BuildTask *task = static_cast<BuildTask*>(arg);
+		BuildJob *job = task->job;
+		const Dictionary *dictionary = job->dictionary;
+		S32 *offsets = job->offsets + task->index * job->threadCount;
+
+		const S32 end = sliceStart(job, task->index + 1);
+		for (S32 i = sliceStart(job, task->index); i < end; ++i)
+		{
+			const S32 range = rangeOf(dictionary->mBuckets.bucketIndex(job->hashes[i]), dictionary->mTableSize, job->threadCount);
+			job->order[offsets[range]++] = i;
+		}
+	}
+
+	/// Inserts the pairs of the range of a task. Chained cells come from the
+	/// pool of the task.
+	static void fillRange(void *arg)
+	{
+		BuildTask *task = static_cast<BuildTask*>(arg);
+		BuildJob *job = task->job;
+		Dictionary *dictionary = job->dictionary;
+
+		const S32 end = job->rangeStarts[task->index + 1];
+		for (S32 j = job->rangeStarts[task->index]; j < end; ++j)
+		{
+			const S32 i = job->order[j];
+			const KVPair &pair = job->pairs[i];
+			const size_t keyHash = job->hashes[i];
+			TableCell *tableCell = &dictionary->mTable[dictionary->mBuckets.bucketIndex(keyHash)];
+			if (dictionary->findCell(tableCell, keyHash, pair.key) != nullptr)
+				continue;
+
+			if (!tableCell->hasData)
+			{
+				new (static_cast<Cell*>(tableCell)) Cell(keyHash, pair.key, pair.value);
+				dictionary->setOccupied(tableCell, true);
+			}
+			else
+			{
+				dictionary->linkAfterTableCell(tableCell, task->pool.construct(keyHash, pair.key, pair.value));
+			}
+			++task->inserted;
+		}
+	}
+
+	static FORCE_INLINE S32 sliceStart(const BuildJob *job, S32 slice)
+	{
+		return static_cast<S32>(static_cast<S64>(job->pairCount) * slice / job->threadCount);
+	}
+
+	void linkAfterTableCell(TableCell *tableCell, Cell *cell)
+	{
+		cell->previous = static_cast<Cell*>(tableCell);
+		cell->next = tableCell->next;
+		if (tableCell->next != nullptr)
+			tableCell->next->previous = cell;
+		tableCell->next = cell;
+	}
 };
 
 #endif // _JBL_DICTIONARY_HPP_
\ No newline at end of file
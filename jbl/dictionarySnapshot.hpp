@@ -0,0 +1,405 @@
+//-----------------------------------------------------------------------------
+// dictionarySnapshot.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_DICTIONARYSNAPSHOT_HPP_
+#define _JBL_DICTIONARYSNAPSHOT_HPP_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "types.hpp"
+#include "lib.hpp"
+#include "typetraits.hpp"
+#include "string.hpp"
+#include "hash.hpp"
+#include "dictionary.hpp"
+#include "mappedFile.hpp"
+
+/// The results of opening a DictionarySnapshot.
+enum SnapshotResult
+{
+	eSnapshotOk,
+	eSnapshotFileError,
+	eSnapshotBadFormat,
+	eSnapshotBadVersion,
+	eSnapshotBadValueType,
+	eSnapshotBadChecksum
+};
+
+/// The header at the start of every snapshot file. Every section after it
+/// starts at an offset from the start of the file that is a multiple of
+/// eSectionAlignment, so the file can be used in place wherever it is
+/// mapped. Numbers are stored in the byte order of the machine that wrote
+/// the file; a file from a machine with the other byte order fails to open
+/// because of its magic.
+struct DictionarySnapshotHeader
+{
+	enum Constants
+	{
+		eMagic = 0x534C424A, // "JBLS"
+		eVersion = 1,
+		eSectionAlignment = 64
+	};
+
+	U32 magic;
+	U32 version;
+	U32 valueSize;
+	U32 valueAlignment;
+
+	U64 count;
+	U64 bucketCount;
+
+	/// bucketCount + 1 U32s. The entries of bucket b are the ones from
+	/// buckets[b] up to buckets[b + 1].
+	U64 bucketsOffset;
+
+	/// count DictionarySnapshotEntry's, sorted by bucket.
+	U64 entriesOffset;
+
+	/// count values, in the same order as the entries.
+	U64 valuesOffset;
+
+	/// The bytes of every key, each followed by a null terminator.
+	U64 stringsOffset;
+
+	U64 fileSize;
+
+	/// Checksum of the whole file, taken while this field was 0.
+	U64 checksum;
+};
+
+/// A key within a snapshot file.
+struct DictionarySnapshotEntry
+{
+	U64 hash;
+
+	/// The offset of the key from the start of the strings section.
+	U64 keyOffset;
+
+	U32 keyLength;
+	U32 reserved;
+};
+
+/// An immutable Dictionary<String, DictionaryValue> that is used straight
+/// out of a memory mapped file. Opening one costs a handful of page faults
+/// no matter how many elements it holds, and processes that map the same
+/// file share its pages.
+///
+/// The values are copied into the file byte for byte, so they have to be
+/// trivially copyable and must not hold pointers.
+///
+/// Keys are hashed with a fixed hash that belongs to the file format, and
+/// not with HashFunction, so that files stay valid when HashFunction
+/// changes or is seeded per process. The flip side is that the layout of a
+/// file is predictable, so only map files that come from a trusted writer.
+template<typename DictionaryValue>
+class DictionarySnapshot
+{
+	static_assert(TypeTraits::IsTriviallyCopyable<DictionaryValue>::value, "DictionarySnapshot values have to be trivially copyable.");
+	static_assert(alignof(DictionaryValue) <= DictionarySnapshotHeader::eSectionAlignment, "DictionarySnapshot values are aligned too strictly.");
+
+public:
+	DictionarySnapshot()
+	{
+		clearSections();
+	}
+
+	DictionarySnapshot(const DictionarySnapshot &) = delete;
+	DictionarySnapshot& operator=(const DictionarySnapshot &) = delete;
+
+	/// Writes a dictionary to a snapshot file, replacing the file. Processes
+	/// that have the file mapped see it change underneath them, so write to
+	/// a new path and rename it over the old one instead.
+	/// @param dictionary The dictionary to write.
+	/// @param path The path of the file to write.
+	/// @return true if the file was written, false otherwise.
+	template<class Hash, class BucketPolicy>
+	static bool write(const Dictionary<String, DictionaryValue, Hash, BucketPolicy> &dictionary, const char *path)
+	{
+		const U64 count = static_cast<U64>(dictionary.count());
+		U64 bucketCount = 1;
+		while (bucketCount < count)
+			bucketCount <<= 1;
+
+		U64 stringBytes = 0;
+		for (auto &pair : dictionary)
+			stringBytes += static_cast<U64>(pair.key.length()) + 1;
+
+		DictionarySnapshotHeader header;
+		memset(&header, 0, sizeof(header));
+		header.magic = DictionarySnapshotHeader::eMagic;
+		header.version = DictionarySnapshotHeader::eVersion;
+		header.valueSize = sizeof(DictionaryValue);
+		header.valueAlignment = alignof(DictionaryValue);
+		header.count = count;
+		header.bucketCount = bucketCount;
+		header.bucketsOffset = alignSection(sizeof(header));
+		header.entriesOffset = alignSection(header.bucketsOffset + (bucketCount + 1) * sizeof(U32));
+		header.valuesOffset = alignSection(header.entriesOffset + count * sizeof(DictionarySnapshotEntry));
+		header.stringsOffset = alignSection(header.valuesOffset + count * sizeof(DictionaryValue));
+		header.fileSize = header.stringsOffset + stringBytes;
+
+		// Zeroed, so that padding is the same every time it is written.
+		U8 *file = static_cast<U8*>(calloc(static_cast<size_t>(header.fileSize), 1));
+		if (file == nullptr)
+			return false;
+
+		U32 *buckets = reinterpret_cast<U32*>(file + header.bucketsOffset);
+		DictionarySnapshotEntry *entries = reinterpret_cast<DictionarySnapshotEntry*>(file + header.entriesOffset);
+		U8 *values = file + header.valuesOffset;
+		char *strings = reinterpret_cast<char*>(file + header.stringsOffset);
+
+		// Counting sort by bucket: count every bucket, turn the counts into
+		// starting positions, then place every element behind its bucket.
+		for (auto &pair : dictionary)
+			++buckets[bucketIndex(hashKey(pair.key), bucketCount) + 1];
+		for (U64 i = 0; i < bucketCount; ++i)
+			buckets[i + 1] += buckets[i];
+
+		U32 *cursors = static_cast<U32*>(malloc(static_cast<size_t>(bucketCount) * sizeof(U32)));
+		if (cursors == nullptr)
+		{
+			free(file);
+			return false;
+		}
+		memcpy(cursors, buckets, static_cast<size_t>(bucketCount) * sizeof(U32));
+
+		U64 stringPos = 0;
+		for (auto &pair : dictionary)
+		{
+			const U64 hash = hashKey(pair.key);
+			const U32 index = cursors[bucketIndex(hash, bucketCount)]++;
+
+			DictionarySnapshotEntry &entry = entries[index];
+			entry.hash = hash;
+			entry.keyOffset = stringPos;
+			entry.keyLength = static_cast<U32>(pair.key.length());
+			memcpy(values + index * sizeof(DictionaryValue), &pair.value, sizeof(DictionaryValue));
+
+			memcpy(strings + stringPos, pair.key.c_str(), entry.keyLength);
+			stringPos += entry.keyLength + 1;
+		}
+		free(cursors);
+
+		memcpy(file, &header, sizeof(header));
+		header.checksum = checksum(file, static_cast<size_t>(header.fileSize));
+		memcpy(file, &header, sizeof(header));
+
+		FILE *stream = fopen(path, "wb");
+		bool written = stream != nullptr;
+		if (written)
+		{
+			written = fwrite(file, 1, static_cast<size_t>(header.fileSize), stream) == header.fileSize;
+			written = fclose(stream) == 0 && written;
+		}
+
+		free(file);
+		return written;
+	}
+
+	/// Maps a snapshot file, closing the previous one.
+	/// @param path The path of the file to map.
+	/// @param verifyChecksum Whether to checksum the file. This reads every
+	///  page of it once. Skip it only for files that are known to be intact,
+	///  as lookups trust the offsets within the file.
+	/// @return eSnapshotOk if the snapshot can be used, the reason it cannot
+	///  be used otherwise.
+	SnapshotResult open(const char *path, bool verifyChecksum = true)
+	{
+		close();
+		if (!mFile.open(path))
+			return eSnapshotFileError;
+
+		const SnapshotResult result = validate(verifyChecksum);
+		if (result != eSnapshotOk)
+		{
+			close();
+			return result;
+		}
+
+		const U8 *file = mFile.data();
+		const DictionarySnapshotHeader *header = reinterpret_cast<const DictionarySnapshotHeader*>(file);
+		mCount = header->count;
+		mBucketMask = header->bucketCount - 1;
+		mBuckets = reinterpret_cast<const U32*>(file + header->bucketsOffset);
+		mEntries = reinterpret_cast<const DictionarySnapshotEntry*>(file + header->entriesOffset);
+		mValues = reinterpret_cast<const DictionaryValue*>(file + header->valuesOffset);
+		mStrings = reinterpret_cast<const char*>(file + header->stringsOffset);
+		return eSnapshotOk;
+	}
+
+	/// Unmaps the snapshot. Every pointer that find returned becomes invalid.
+	void close()
+	{
+		mFile.close();
+		clearSections();
+	}
+
+	/// Checks to see if a snapshot is open.
+	/// @return true if a snapshot is open, false otherwise.
+	FORCE_INLINE bool isOpen() const
+	{
+		return mFile.isOpen();
+	}
+
+	/// Looks up a key.
+	/// @param key The key to look for.
+	/// @return The value of the key, which lives as long as the snapshot is
+	///  open, or nullptr if the key was not found.
+	const DictionaryValue* find(const StringView &key) const
+	{
+		if (mBuckets == nullptr)
+			return nullptr;
+
+		const U64 hash = hashKey(key);
+		const U64 bucket = hash & mBucketMask;
+		const U32 end = mBuckets[bucket + 1];
+		for (U32 i = mBuckets[bucket]; i < end; ++i)
+		{
+			const DictionarySnapshotEntry &entry = mEntries[i];
+			if (entry.hash == hash && entry.keyLength == static_cast<U32>(key.length()) &&
+				memcmp(mStrings + entry.keyOffset, key.data(), entry.keyLength) == 0)
+				return &mValues[i];
+		}
+		return nullptr;
+	}
+
+	/// Checks to see if the snapshot contains key.
+	/// @param key The key to look for.
+	/// @return true if the key is within the snapshot, false otherwise.
+	FORCE_INLINE bool contains(const StringView &key) const
+	{
+		return find(key) != nullptr;
+	}
+
+	/// Gets the amount of elements within the snapshot.
+	/// @return The amount of elements, or 0 if no snapshot is open.
+	FORCE_INLINE S32 count() const
+	{
+		return static_cast<S32>(mCount);
+	}
+
+private:
+	MappedFile mFile;
+	U64 mCount;
+	U64 mBucketMask;
+	const U32 *mBuckets;
+	const DictionarySnapshotEntry *mEntries;
+	const DictionaryValue *mValues;
+	const char *mStrings;
+
+	void clearSections()
+	{
+		mCount = 0;
+		mBucketMask = 0;
+		mBuckets = nullptr;
+		mEntries = nullptr;
+		mValues = nullptr;
+		mStrings = nullptr;
+	}
+
+	SnapshotResult validate(bool verifyChecksum) const
+	{
+		const U8 *file = mFile.data();
+		const U64 size = static_cast<U64>(mFile.size());
+		if (size < sizeof(DictionarySnapshotHeader))
+			return eSnapshotBadFormat;
+
+		DictionarySnapshotHeader header;
+		memcpy(&header, file, sizeof(header));
+		if (header.magic != DictionarySnapshotHeader::eMagic)
+			return eSnapshotBadFormat;
+		if (header.version != DictionarySnapshotHeader::eVersion)
+			return eSnapshotBadVersion;
+		if (header.valueSize != sizeof(DictionaryValue) || header.valueAlignment != alignof(DictionaryValue))
+			return eSnapshotBadValueType;
+
+		// Every section has to be where the writer puts it, which also keeps
+		// them within the file.
+		const bool powerOfTwo = header.bucketCount != 0 && (header.bucketCount & (header.bucketCount - 1)) == 0;
+		if (!powerOfTwo || header.count > header.bucketCount || header.fileSize != size ||
+			header.bucketsOffset != alignSection(sizeof(header)) ||
+			header.entriesOffset != alignSection(header.bucketsOffset + (header.bucketCount + 1) * sizeof(U32)) ||
+			header.valuesOffset != alignSection(header.entriesOffset + header.count * sizeof(DictionarySnapshotEntry)) ||
+			header.stringsOffset != alignSection(header.valuesOffset + header.count * sizeof(DictionaryValue)) ||
+			header.stringsOffset > size)
+			return eSnapshotBadFormat;
+
+		if (verifyChecksum)
+		{
+			const U64 expected = header.checksum;
+			header.checksum = 0;
+			U64 state = checksum(reinterpret_cast<const U8*>(&header), sizeof(header));
+			state = checksum(file + sizeof(header), static_cast<size_t>(size - sizeof(header)), state);
+			if (state != expected)
+				return eSnapshotBadChecksum;
+		}
+
+		return eSnapshotOk;
+	}
+
+	static FORCE_INLINE U64 alignSection(U64 offset)
+	{
+		const U64 alignment = DictionarySnapshotHeader::eSectionAlignment;
+		return (offset + alignment - 1) & ~(alignment - 1);
+	}
+
+	static FORCE_INLINE U64 bucketIndex(U64 hash, U64 bucketCount)
+	{
+		return hash & (bucketCount - 1);
+	}
+
+	/// The hash of the file format. It must never change without bumping
+	/// eVersion. FNV-1a, with finalizeHash64 so that the low bits that pick the
+	/// bucket depend on every byte.
+	static U64 hashKey(const StringView &key)
+	{
+		U64 hash = 0xCBF29CE484222325ULL;
+		const U8 *bytes = reinterpret_cast<const U8*>(key.data());
+		for (S32 i = 0; i < key.length(); ++i)
+			hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+
+		return finalizeHash64(hash);
+	}
+
+	/// FNV-1a over 8 bytes at a time, so that checking a large file is
+	/// bound by reading it. Checksumming a buffer in pieces gives the same
+	/// result as all at once as long as every piece but the last is a
+	/// multiple of 8 bytes long.
+	static U64 checksum(const U8 *data, size_t size, U64 state = 0xCBF29CE484222325ULL)
+	{
+		size_t i = 0;
+		for (; i + sizeof(U64) <= size; i += sizeof(U64))
+		{
+			U64 word;
+			memcpy(&word, data + i, sizeof(U64));
+			state = (state ^ word) * 0x100000001B3ULL;
+		}
+		for (; i < size; ++i)
+			state = (state ^ data[i]) * 0x100000001B3ULL;
+		return state;
+	}
+};
+
+#endif // _JBL_DICTIONARYSNAPSHOT_HPP_
@@ -0,0 +1,198 @@
+//-----------------------------------------------------------------------------
+// filteredDictionary.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_FILTEREDDICTIONARY_HPP_
+#define _JBL_FILTEREDDICTIONARY_HPP_
+
+#include "lib.hpp"
+#include "hashFunction.hpp"
+#include "dictionary.hpp"
+#include "cuckooFilter.hpp"
+
+/// A Dictionary with a CuckooFilter in front of it, for tables where most
+/// lookups are for keys that are not there. A miss is answered by the
+/// filter alone, without touching the table, its chains or any key.
+///
+/// Hits hash the key twice, once for the filter and once for the table,
+/// and a false positive costs a full miss in the table as well. Use this
+/// only where misses dominate.
+template<typename DictionaryKey, typename DictionaryValue, class Hash = HashFunction<DictionaryKey>>
+class FilteredDictionary
+{
+public:
+	typedef Dictionary<DictionaryKey, DictionaryValue, Hash> Table;
+	typedef typename Table::LookupKey LookupKey;
+	typedef typename Table::Iterator Iterator;
+	typedef typename Table::CIterator CIterator;
+	typedef typename Table::InsertResult InsertResult;
+
+	/// Creates a FilteredDictionary.
+	/// @param expectedCount The amount of elements to size the table and the
+	///  filter for. Both grow past it when needed.
+	explicit FilteredDictionary(S32 expectedCount = eDefaultExpectedCount) :
+		mFilter(expectedCount)
+	{
+		mTable.reserve(expectedCount);
+		mFilterCapacity = mMax(expectedCount, 1);
+	}
+
+	FilteredDictionary(const FilteredDictionary &) = delete;
+	FilteredDictionary& operator=(const FilteredDictionary &) = delete;
+
+	/// Inserts a key/value pair if the key is not within the dictionary yet.
+	/// @return The position of the element with the key, and whether or not
+	///  it was inserted.
+	InsertResult insert(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		InsertResult result = mTable.insert(key, value);
+		if (result.inserted)
+			addToFilter(key);
+		return result;
+	}
+
+	/// Inserts a key/value pair, or assigns value to the existing element if
+	/// the key is already within the dictionary.
+	/// @return The position of the element with the key, and whether or not
+	///  it was inserted.
+	InsertResult insertOrAssign(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		InsertResult result = mTable.insertOrAssign(key, value);
+		if (result.inserted)
+			addToFilter(key);
+		return result;
+	}
+
+	Iterator find(const LookupKey &key)
+	{
+		return mFilter.mayContain(key) ? mTable.find(key) : mTable.end();
+	}
+
+	CIterator find(const LookupKey &key) const
+	{
+		return mFilter.mayContain(key) ? mTable.find(key) : mTable.end();
+	}
+
+	/// Checks to see if the dictionary contains key.
+	/// @param key The key to look for.
+	/// @return true if the key is within the dictionary, false otherwise.
+	bool contains(const LookupKey &key) const
+	{
+		return mFilter.mayContain(key) && mTable.contains(key);
+	}
+
+	/// Erases the element with the key.
+	/// @return true if an element was erased, false if the key was not found.
+	bool erase(const LookupKey &key)
+	{
+		Iterator position = find(key);
+		if (position == mTable.end())
+			return false;
+
+		mFilter.erase(key);
+		mTable.erase(position);
+		return true;
+	}
+
+	/// Removes every element from the dictionary.
+	void clear()
+	{
+		mTable.clear();
+		mFilter.clear();
+	}
+
+	/// Gets the amount of elements within the dictionary.
+	/// @return The amount of elements in the dictionary.
+	FORCE_INLINE S32 count() const
+	{
+		return mTable.count();
+	}
+
+	/// Gets the dictionary behind the filter, to iterate over it or inspect
+	/// it.
+	FORCE_INLINE const Table& table() const
+	{
+		return mTable;
+	}
+
+	FORCE_INLINE Iterator begin()
+	{
+		return mTable.begin();
+	}
+
+	FORCE_INLINE Iterator end()
+	{
+		return mTable.end();
+	}
+
+	FORCE_INLINE CIterator begin() const
+	{
+		return mTable.begin();
+	}
+
+	FORCE_INLINE CIterator end() const
+	{
+		return mTable.end();
+	}
+
+private:
+	enum Constants
+	{
+		eDefaultExpectedCount = 16
+	};
+
+	Table mTable;
+	CuckooFilter<DictionaryKey, Hash> mFilter;
+	S32 mFilterCapacity;
+
+	void addToFilter(const DictionaryKey &key)
+	{
+		if (mFilter.insert(key) && !mFilter.isFull() && mTable.count() <= mFilterCapacity)
+			return;
+
+		// A full filter is rebuilt twice as large from the keys in the
+		// table, which already holds the new key. The rebuild can run out of
+		// room as well, which would leave keys out of the filter, so it is
+		// retried twice as large again until every key made it in.
+		mFilterCapacity = mMax(mFilterCapacity * 2, mTable.count());
+		while (!rebuildFilter())
+			mFilterCapacity *= 2;
+	}
+
+	/// Fills the filter with every key of the table, sized for
+	/// mFilterCapacity keys.
+	/// @return true if every key was added, false if the filter ran out of
+	///  room.
+	bool rebuildFilter()
+	{
+		mFilter.reset(mFilterCapacity);
+		for (auto &pair : mTable)
+		{
+			if (!mFilter.insert(pair.key))
+				return false;
+		}
+		return true;
+	}
+};
+
+#endif // _JBL_FILTEREDDICTIONARY_HPP_
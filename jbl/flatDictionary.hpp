@@ -0,0 +1,522 @@
+//-----------------------------------------------------------------------------
+// flatDictionary.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_FLATDICTIONARY_HPP_
+#define _JBL_FLATDICTIONARY_HPP_
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include "lib.hpp"
+#include "hashFunction.hpp"
+#include "vector.hpp"
+
+/// A map that keeps its keys sorted in one contiguous array and its values
+/// in another one, at the same positions.
+///
+/// Lookups are a branchless binary search over the keys only, so a lookup
+/// touches a handful of cache lines of keys and never hashes anything.
+/// For small maps, and maps that are built once and then only read, this
+/// is faster than a hash table. Inserting and erasing shift every element
+/// after the position, so use build() to fill a map all at once.
+///
+/// Like Vector, elements are moved around with memmove and realloc, so keys
+/// and values must not hold pointers into themselves. Keys need operator<
+/// and equals against LookupKey.
+template<typename DictionaryKey, typename DictionaryValue>
+class FlatDictionary
+{
+public:
+	/// The type that keys are looked up by. For String keys this is a
+	/// StringView, the same as for Dictionary.
+	typedef typename LookupKeyType<DictionaryKey>::Type LookupKey;
+
+	/// A key/value pair, used to build() a FlatDictionary.
+	struct KVPair
+	{
+		DictionaryKey key;
+		DictionaryValue value;
+	};
+
+	/// What iterators point at. The keys and the values live in separate
+	/// arrays, so this refers to both of them instead of holding a pair.
+	struct Element
+	{
+		const DictionaryKey &key;
+		DictionaryValue &value;
+	};
+
+	/// What constant iterators point at.
+	struct CElement
+	{
+		const DictionaryKey &key;
+		const DictionaryValue &value;
+	};
+
+	/// A class that is responsible for iterating over a FlatDictionary in
+	/// key order. It performs forward iteration at O(n) time.
+	/// @see CIterator
+	class Iterator
+	{
+		friend class FlatDictionary;
+	public:
+		/// Incriments the iterator to advance it to access the next element.
+		/// @return The current iterator.
+		Iterator& operator++()
+		{
+			++mPosition;
+			return *this;
+		}
+
+		bool operator==(const Iterator &it) const
+		{
+			return mPosition == it.mPosition;
+		}
+
+		bool operator!=(const Iterator &it) const
+		{
+			return mPosition != it.mPosition;
+		}
+
+		/// Dereferences the current element at the current iterator position.
+		/// @return References to the key and the value at the current position.
+		Element operator*() const
+		{
+			assert(mPosition < mDictionary->mCount);
+			return Element{mDictionary->mKeys[mPosition], mDictionary->mValues[mPosition]};
+		}
+
+	private:
+		FlatDictionary *mDictionary;
+		S32 mPosition;
+
+		Iterator(FlatDictionary *dictionary, S32 position)
+		{
+			mDictionary = dictionary;
+			mPosition = position;
+		}
+	};
+
+	/// A class that is responsible for iterating over a FlatDictionary in
+	/// key order. Unlike Iterator, this version is a constant iterator.
+	/// @see Iterator
+	class CIterator
+	{
+		friend class FlatDictionary;
+	public:
+		/// Incriments the iterator to advance it to access the next element.
+		/// @return The current iterator.
+		CIterator& operator++()
+		{
+			++mPosition;
+			return *this;
+		}
+
+		bool operator==(const CIterator &it) const
+		{
+			return mPosition == it.mPosition;
+		}
+
+		bool operator!=(const CIterator &it) const
+		{
+			return mPosition != it.mPosition;
+		}
+
+		/// Dereferences the current element at the current iterator position.
+		/// @return References to the key and the value at the current position.
+		CElement operator*() const
+		{
+			assert(mPosition < mDictionary->mCount);
+			return CElement{mDictionary->mKeys[mPosition], mDictionary->mValues[mPosition]};
+		}
+
+	private:
+		const FlatDictionary *mDictionary;
+		S32 mPosition;
+
+		CIterator(const FlatDictionary *dictionary, S32 position)
+		{
+			mDictionary = dictionary;
+			mPosition = position;
+		}
+	};
+
+	/// The result of an insertion. iterator points at the element with the
+	/// key, whether it was just inserted or was already there.
+	struct InsertResult
+	{
+		Iterator iterator;
+		bool inserted;
+	};
+
+	/// Creates a FlatDictionary.
+	/// @param capacity The amount of elements to make room for up front.
+	explicit FlatDictionary(S32 capacity = 0)
+	{
+		mKeys = nullptr;
+		mValues = nullptr;
+		mCount = 0;
+		mCapacity = 0;
+		reserve(capacity);
+	}
+
+	FlatDictionary(const FlatDictionary &) = delete;
+	FlatDictionary& operator=(const FlatDictionary &) = delete;
+
+	FlatDictionary(FlatDictionary &&dict)
+	{
+		takeArrays(dict);
+	}
+
+	FlatDictionary& operator=(FlatDictionary &&dict)
+	{
+		if (this != &dict)
+		{
+			destroyElements();
+			free(mKeys);
+			free(mValues);
+			takeArrays(dict);
+		}
+		return *this;
+	}
+
+	~FlatDictionary()
+	{
+		destroyElements();
+		free(mKeys);
+		free(mValues);
+	}
+
+	/// Replaces the contents of the dictionary with pairs, which do not have
+	/// to be sorted. This sorts once instead of shifting on every insertion.
+	/// If a key is in pairs more than once, the first pair wins, the same as
+	/// inserting the pairs one by one would.
+	/// @param pairs The pairs to build the dictionary from.
+	/// @param count The amount of pairs.
+	void build(const KVPair *pairs, S32 count)
+	{
+		clear();
+		reserve(count);
+		if (count == 0)
+			return;
+
+		// Sort positions into pairs instead of the pairs themselves, so that
+		// nothing is copied more than once. The sort is stable, which keeps
+		// the first of equal keys in front.
+		S32 *order = static_cast<S32*>(malloc(sizeof(S32) * count * 2));
+		S32 *scratch = order + count;
+		for (S32 i = 0; i < count; ++i)
+			order[i] = i;
+		sortPositions(pairs, order, scratch, count);
+
+		for (S32 i = 0; i < count; ++i)
+		{
+			const KVPair &pair = pairs[order[i]];
+			if (mCount != 0 && !(mKeys[mCount - 1] < pair.key))
+				continue;
+
+			new (&mKeys[mCount]) DictionaryKey(pair.key);
+			new (&mValues[mCount]) DictionaryValue(pair.value);
+			++mCount;
+		}
+
+		free(order);
+	}
+
+	/// Replaces the contents of the dictionary with pairs.
+	/// @see build(const KVPair*, S32)
+	void build(const Vector<KVPair> &pairs)
+	{
+		build(pairs.count() != 0 ? &pairs[0] : nullptr, pairs.count());
+	}
+
+	/// Gets the value of key, inserting a default constructed value if the
+	/// key is not within the dictionary yet.
+	DictionaryValue& operator[](const LookupKey &key)
+	{
+		const S32 position = lowerBound(key);
+		if (!isMatch(position, key))
+			insertAt(position, DictionaryKey(key), DictionaryValue());
+		return mValues[position];
+	}
+
+	/// Inserts a key/value pair if the key is not within the dictionary yet.
+	/// @return The position of the element with the key, and whether or not
+	///  it was inserted.
+	/// @note An insertion shifts the elements after it, which invalidates
+	///  iterators.
+	InsertResult insert(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		const S32 position = lowerBound(key);
+		if (isMatch(position, key))
+			return InsertResult{Iterator(this, position), false};
+
+		insertAt(position, key, value);
+		return InsertResult{Iterator(this, position), true};
+	}
+
+	/// Inserts a key/value pair, or assigns value to the existing element if
+	/// the key is already within the dictionary.
+	/// @return The position of the element with the key, and whether or not
+	///  it was inserted.
+	InsertResult insertOrAssign(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		const S32 position = lowerBound(key);
+		if (isMatch(position, key))
+		{
+			mValues[position] = value;
+			return InsertResult{Iterator(this, position), false};
+		}
+
+		insertAt(position, key, value);
+		return InsertResult{Iterator(this, position), true};
+	}
+
+	Iterator find(const LookupKey &key)
+	{
+		const S32 position = lowerBound(key);
+		return isMatch(position, key) ? Iterator(this, position) : end();
+	}
+
+	CIterator find(const LookupKey &key) const
+	{
+		const S32 position = lowerBound(key);
+		return isMatch(position, key) ? CIterator(this, position) : end();
+	}
+
+	/// Checks to see if the dictionary contains key.
+	/// @param key The key to look for.
+	/// @return true if the key is within the dictionary, false otherwise.
+	bool contains(const LookupKey &key) const
+	{
+		return isMatch(lowerBound(key), key);
+	}
+
+	/// Erases the element at the iterator position.
+	/// @param iterator The position of the element to erase.
+	/// @return An iterator to the element following the erased element.
+	Iterator erase(Iterator iterator)
+	{
+		const S32 position = iterator.mPosition;
+		assert(position < mCount);
+
+		mKeys[position].~DictionaryKey();
+		mValues[position].~DictionaryValue();
+
+		// Shift everything after it down by one to keep the arrays compact.
+		--mCount;
+		const size_t moved = static_cast<size_t>(mCount - position);
+		memmove(static_cast<void*>(mKeys + position), mKeys + position + 1, moved * sizeof(DictionaryKey));
+		memmove(static_cast<void*>(mValues + position), mValues + position + 1, moved * sizeof(DictionaryValue));
+		return iterator;
+	}
+
+	/// Removes every element from the dictionary. The memory is kept.
+	void clear()
+	{
+		destroyElements();
+		mCount = 0;
+	}
+
+	/// Makes sure that the dictionary can hold at least count elements
+	/// without reallocating.
+	void reserve(S32 count)
+	{
+		if (count <= mCapacity)
+			return;
+
+		mKeys = static_cast<DictionaryKey*>(realloc(static_cast<void*>(mKeys), sizeof(DictionaryKey) * count));
+		mValues = static_cast<DictionaryValue*>(realloc(static_cast<void*>(mValues), sizeof(DictionaryValue) * count));
+		mCapacity = count;
+	}
+
+	/// Gets the amount of elements within the dictionary.
+	/// @return The amount of elements in the dictionary.
+	FORCE_INLINE S32 count() const
+	{
+		return mCount;
+	}
+
+	/// Gets the amount of elements the dictionary has memory for.
+	/// @return The capacity of the dictionary.
+	FORCE_INLINE S32 capacity() const
+	{
+		return mCapacity;
+	}
+
+	/// Grabs an iterator at the smallest key of the FlatDictionary.
+	FORCE_INLINE Iterator begin()
+	{
+		return Iterator(this, 0);
+	}
+
+	/// Grabs an iterator at the end of the FlatDictionary.
+	FORCE_INLINE Iterator end()
+	{
+		return Iterator(this, mCount);
+	}
+
+	/// Grabs a constant iterator at the smallest key of the FlatDictionary.
+	FORCE_INLINE CIterator begin() const
+	{
+		return CIterator(this, 0);
+	}
+
+	/// Grabs a constant iterator at the end of the FlatDictionary.
+	FORCE_INLINE CIterator end() const
+	{
+		return CIterator(this, mCount);
+	}
+
+private:
+	enum Constants
+	{
+		// Maps up to this size are searched linearly.
+		eLinearSearchCount = 16
+	};
+
+	/// The sorted keys.
+	DictionaryKey *mKeys;
+
+	/// The values, at the same positions as their keys.
+	DictionaryValue *mValues;
+
+	S32 mCount;
+	S32 mCapacity;
+
+	/// Finds the position of the first key that is not less than key.
+	///
+	/// Every step halves the range by moving its start, and the choice of
+	/// start compiles to a conditional move instead of a branch. The
+	/// amount of steps only depends on the amount of keys, so there is
+	/// nothing for the branch predictor to get wrong.
+	S32 lowerBound(const LookupKey &key) const
+	{
+		if (mCount <= eLinearSearchCount)
+		{
+			// Small maps count the smaller keys instead, which has no
+			// dependency between the steps at all.
+			S32 position = 0;
+			for (S32 i = 0; i < mCount; ++i)
+				position += static_cast<S32>(mKeys[i] < key);
+			return position;
+		}
+
+		const DictionaryKey *base = mKeys;
+		S32 length = mCount;
+		while (length > 1)
+		{
+			const S32 half = length / 2;
+			// Compilers turn a ternary here back into a branch, the
+			// multiply keeps the data dependency instead.
+			base += static_cast<S32>(base[half - 1] < key) * half;
+			length -= half;
+		}
+		return static_cast<S32>(base - mKeys) + ((*base < key) ? 1 : 0);
+	}
+
+	FORCE_INLINE bool isMatch(S32 position, const LookupKey &key) const
+	{
+		return position < mCount && equals(mKeys[position], key);
+	}
+
+	template<typename K, typename V>
+	void insertAt(S32 position, K &&key, V &&value)
+	{
+		if (mCount == mCapacity)
+			reserve(mMax(4, mCapacity * 2));
+
+		const size_t moved = static_cast<size_t>(mCount - position);
+		memmove(static_cast<void*>(mKeys + position + 1), mKeys + position, moved * sizeof(DictionaryKey));
+		memmove(static_cast<void*>(mValues + position + 1), mValues + position, moved * sizeof(DictionaryValue));
+
+		new (&mKeys[position]) DictionaryKey(static_cast<K&&>(key));
+		new (&mValues[position]) DictionaryValue(static_cast<V&&>(value));
+		++mCount;
+	}
+
+	void destroyElements()
+	{
+		for (S32 i = 0; i < mCount; ++i)
+		{
+			mKeys[i].~DictionaryKey();
+			mValues[i].~DictionaryValue();
+		}
+	}
+
+	void takeArrays(FlatDictionary &dict)
+	{
+		mKeys = dict.mKeys;
+		mValues = dict.mValues;
+		mCount = dict.mCount;
+		mCapacity = dict.mCapacity;
+
+		dict.mKeys = nullptr;
+		dict.mValues = nullptr;
+		dict.mCount = 0;
+		dict.mCapacity = 0;
+	}
+
+	/// Stable bottom up merge sort of positions into pairs by key.
+	static void sortPositions(const KVPair *pairs, S32 *order, S32 *scratch, S32 count)
+	{
+		S32 *from = order;
+		S32 *to = scratch;
+		for (S32 width = 1; width < count; width *= 2)
+		{
+			for (S32 start = 0; start < count; start += width * 2)
+			{
+				const S32 middle = mMin(start + width, count);
+				const S32 stop = mMin(start + width * 2, count);
+
+				S32 left = start;
+				S32 right = middle;
+				S32 out = start;
+				while (left < middle && right < stop)
+				{
+					// Take from the right only if it is strictly smaller,
+					// so that equal keys keep their order.
+					if (pairs[from[right]].key < pairs[from[left]].key)
+						to[out++] = from[right++];
+					else
+						to[out++] = from[left++];
+				}
+				while (left < middle)
+					to[out++] = from[left++];
+				while (right < stop)
+					to[out++] = from[right++];
+			}
+
+			S32 *swap = from;
+			from = to;
+			to = swap;
+		}
+
+		if (from != order)
+			memcpy(order, from, sizeof(S32) * count);
+	}
+};
+
+#endif // _JBL_FLATDICTIONARY_HPP_
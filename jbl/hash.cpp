@@ -0,0 +1,136 @@
+//-----------------------------------------------------------------------------
+// hash.cpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <time.h>
+#include "hash.hpp"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+static FORCE_INLINE U64 readU64(const U8 *data)
+{
+	U64 value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+static FORCE_INLINE U64 readU32(const U8 *data)
+{
+	U32 value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+U64 hashBytes(const void *data, size_t length, U64 seed)
+{
+	const U8 *bytes = static_cast<const U8*>(data);
+	seed ^= hashMix(seed ^ eHashSecret0, eHashSecret1) ^ static_cast<U64>(length);
+
+	U64 a;
+	U64 b;
+	if (length <= 16)
+	{
+		if (length >= 4)
+		{
+			// Two pairs of 4 byte loads that overlap as much as they have
+			// to, which covers every length from 4 to 16.
+			const size_t middle = (length >> 3) << 2;
+			a = (readU32(bytes) << 32) | readU32(bytes + middle);
+			b = (readU32(bytes + length - 4) << 32) | readU32(bytes + length - 4 - middle);
+		}
+		else if (length > 0)
+		{
+			a = (static_cast<U64>(bytes[0]) << 16) | (static_cast<U64>(bytes[length >> 1]) << 8) | bytes[length - 1];
+			b = 0;
+		}
+		else
+		{
+			a = 0;
+			b = 0;
+		}
+	}
+	else
+	{
+		size_t remaining = length;
+		if (remaining > 48)
+		{
+			U64 lane1 = seed;
+			U64 lane2 = seed;
+			do
+			{
+				seed = hashMix(readU64(bytes) ^ eHashSecret1, readU64(bytes + 8) ^ seed);
+				lane1 = hashMix(readU64(bytes + 16) ^ eHashSecret2, readU64(bytes + 24) ^ lane1);
+				lane2 = hashMix(readU64(bytes + 32) ^ eHashSecret3, readU64(bytes + 40) ^ lane2);
+				bytes += 48;
+				remaining -= 48;
+			} while (remaining > 48);
+			seed ^= lane1 ^ lane2;
+		}
+
+		while (remaining > 16)
+		{
+			seed = hashMix(readU64(bytes) ^ eHashSecret1, readU64(bytes + 8) ^ seed);
+			bytes += 16;
+			remaining -= 16;
+		}
+
+		// The last 16 bytes, which may overlap bytes that were already
+		// mixed in.
+		a = readU64(bytes + remaining - 16);
+		b = readU64(bytes + remaining - 8);
+	}
+
+	a ^= eHashSecret1;
+	b ^= seed;
+	hashMultiply(a, b);
+	return hashMix(a ^ eHashSecret0 ^ static_cast<U64>(length), b ^ eHashSecret1);
+}
+
+U64 makeHashSeed()
+{
+	const char *fixed = getenv("JBL_HASH_SEED");
+	if (fixed != nullptr && fixed[0] != '\0')
+		return static_cast<U64>(strtoull(fixed, nullptr, 0));
+
+	static const U8 codeAnchor = 0;
+	U64 seed = static_cast<U64>(time(nullptr));
+	seed = hashMix(seed ^ static_cast<U64>(reinterpret_cast<size_t>(&seed)), eHashSecret0);
+	seed = hashMix(seed ^ static_cast<U64>(reinterpret_cast<size_t>(&codeAnchor)), eHashSecret1);
+	seed = hashMix(seed ^ static_cast<U64>(clock()), eHashSecret2);
+#ifdef _WIN32
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	seed = hashMix(seed ^ static_cast<U64>(counter.QuadPart), eHashSecret3);
+	seed = hashMix(seed ^ static_cast<U64>(GetCurrentProcessId()), eHashSecret0);
+#else
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	seed = hashMix(seed ^ static_cast<U64>(now.tv_nsec), eHashSecret3);
+	seed = hashMix(seed ^ static_cast<U64>(getpid()), eHashSecret0);
+#endif
+	return seed;
+}
@@ -0,0 +1,249 @@
+//-----------------------------------------------------------------------------
+// hash.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_HASH_HPP_
+#define _JBL_HASH_HPP_
+
+#include "lib.hpp"
+
+#if defined(_MSC_VER) && defined(IS_64_BIT)
+#include <intrin.h>
+#endif
+
+/// The constants that hashBytes mixes with. They are odd, and every byte of
+/// them has four bits set, which keeps the multiplications from losing
+/// entropy.
+enum HashSecrets : U64
+{
+	eHashSecret0 = 0x2d358dccaa6c78a5ULL,
+	eHashSecret1 = 0x8bb84b93962eacc9ULL,
+	eHashSecret2 = 0x4b33a62ed433d4a3ULL,
+	eHashSecret3 = 0x4d5a2da51de1aa47ULL
+};
+
+/// Multiplies a and b into a 128 bit product and returns its low half in a
+/// and its high half in b.
+FORCE_INLINE void hashMultiply(U64 &a, U64 &b)
+{
+#if defined(__SIZEOF_INT128__)
+	const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+	a = static_cast<U64>(product);
+	b = static_cast<U64>(product >> 64);
+#elif defined(_MSC_VER) && defined(IS_64_BIT)
+	a = _umul128(a, b, &b);
+#else
+	// Four 32 bit multiplications, for compilers without 128 bit integers.
+	const U64 aHigh = a >> 32;
+	const U64 aLow = static_cast<U32>(a);
+	const U64 bHigh = b >> 32;
+	const U64 bLow = static_cast<U32>(b);
+	const U64 highHigh = aHigh * bHigh;
+	const U64 highLow = aHigh * bLow;
+	const U64 lowHigh = aLow * bHigh;
+	const U64 lowLow = aLow * bLow;
+	const U64 middle = (lowLow >> 32) + static_cast<U32>(highLow) + static_cast<U32>(lowHigh);
+	a = (middle << 32) | static_cast<U32>(lowLow);
+	b = highHigh + (highLow >> 32) + (lowHigh >> 32) + (middle >> 32);
+#endif
+}
+
+/// Folds the 128 bit product of a and b down to 64 bits. Every bit of both
+/// inputs affects every bit of the result.
+FORCE_INLINE U64 hashMix(U64 a, U64 b)
+{
+	hashMultiply(a, b);
+	return a ^ b;
+}
+
+/// The finalizer of MurmurHash3. It is a bijection, so distinct inputs
+/// never collide, and every bit of the input affects every bit of the output.
+FORCE_INLINE U64 finalizeHash64(U64 hash)
+{
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+/// The 32 bit finalizer of MurmurHash3.
+/// @see finalizeHash64
+FORCE_INLINE U32 finalizeHash32(U32 hash)
+{
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6BU;
+	hash ^= hash >> 13;
+	hash *= 0xC2B2AE35U;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+/// The finalizer of MurmurHash3 for the width of size_t.
+/// @see finalizeHash64
+FORCE_INLINE size_t finalizeHash(size_t hash)
+{
+#ifdef IS_64_BIT
+	return static_cast<size_t>(finalizeHash64(static_cast<U64>(hash)));
+#else
+	return static_cast<size_t>(finalizeHash32(static_cast<U32>(hash)));
+#endif
+}
+
+/// Makes up the hash seed of the process. Use hashSeed() instead.
+U64 makeHashSeed();
+
+/// Gets the seed that HashFunction mixes into every hash. It is picked once
+/// per process from the time, the process id and the addresses that address
+/// space layout randomization gives, so that keys cannot be picked up front
+/// to collide. Set the environment variable JBL_HASH_SEED to a number to
+/// fix it, for runs that have to be reproducible.
+///
+/// Hashes are only stable within one process. Anything that is written out
+/// has to use a hash of its own.
+FORCE_INLINE U64 hashSeed()
+{
+	static const U64 seed = makeHashSeed();
+	return seed;
+}
+
+/// Mixes the hash of a value into a running hash. The result depends on
+/// the order of the calls, so (a, b) and (b, a) hash differently, and for a
+/// given seed two different values never give the same result.
+/// @param seed The running hash.
+/// @param value The hash of the next value.
+/// @return The new running hash.
+FORCE_INLINE size_t hashCombine(size_t seed, size_t value)
+{
+	return finalizeHash(seed * static_cast<size_t>(0x9E3779B97F4A7C15ULL) + value + static_cast<size_t>(eHashSecret0));
+}
+
+/// Hashes a block of memory into 64 bits.
+///
+/// This is a multiply and fold hash in the style of wyhash. Up to 16 bytes
+/// are read with a few overlapping loads and no loop at all, longer inputs
+/// are eaten 16 bytes per step, and inputs above 48 bytes run three
+/// independent lanes of 16 bytes each so that the multiplications overlap.
+/// Every load is unaligned and byte order is taken to be little endian.
+///
+/// It is fast and well distributed, but it is not a cryptographic hash, so
+/// it only resists keys that are picked to collide as long as the seed is
+/// not known to whoever picks them.
+/// @param data The memory to hash. May be nullptr if length is 0.
+/// @param length The amount of bytes to hash.
+/// @param seed A value that changes every hash, 0 by default.
+/// @return The hash of the bytes.
+U64 hashBytes(const void *data, size_t length, U64 seed = 0);
+
+/// The parts of compileTimeHash. C++11 constexpr functions are a single
+/// return statement, so every loop of hashBytes is a recursion here.
+namespace HashDetail
+{
+	constexpr U64 byteAt(const char *text, size_t i)
+	{
+		return static_cast<U64>(static_cast<U8>(text[i]));
+	}
+
+	constexpr U64 read32(const char *text, size_t i)
+	{
+		return byteAt(text, i) | (byteAt(text, i + 1) << 8) | (byteAt(text, i + 2) << 16) | (byteAt(text, i + 3) << 24);
+	}
+
+	constexpr U64 read64(const char *text, size_t i)
+	{
+		return read32(text, i) | (read32(text, i + 4) << 32);
+	}
+
+	/// The high half of the 128 bit product, from four 32 bit products.
+	constexpr U64 multiplyHighParts(U64 aHigh, U64 aLow, U64 bHigh, U64 bLow)
+	{
+		return aHigh * bHigh + ((aHigh * bLow) >> 32) + ((aLow * bHigh) >> 32) +
+			((((aLow * bLow) >> 32) + ((aHigh * bLow) & 0xFFFFFFFFULL) + ((aLow * bHigh) & 0xFFFFFFFFULL)) >> 32);
+	}
+
+	constexpr U64 multiplyHigh(U64 a, U64 b)
+	{
+		return multiplyHighParts(a >> 32, a & 0xFFFFFFFFULL, b >> 32, b & 0xFFFFFFFFULL);
+	}
+
+	constexpr U64 mix(U64 a, U64 b)
+	{
+		return (a * b) ^ multiplyHigh(a, b);
+	}
+
+	constexpr U64 finish(U64 a, U64 b, size_t length)
+	{
+		return mix((a * b) ^ eHashSecret0 ^ static_cast<U64>(length), multiplyHigh(a, b) ^ eHashSecret1);
+	}
+
+	constexpr U64 shortHash(const char *text, size_t length, U64 seed, size_t middle)
+	{
+		return length >= 4 ?
+			finish(((read32(text, 0) << 32) | read32(text, middle)) ^ eHashSecret1,
+				((read32(text, length - 4) << 32) | read32(text, length - 4 - middle)) ^ seed, length) :
+			length > 0 ?
+			finish(((byteAt(text, 0) << 16) | (byteAt(text, length >> 1) << 8) | byteAt(text, length - 1)) ^ eHashSecret1, seed, length) :
+			finish(eHashSecret1, seed, length);
+	}
+
+	constexpr U64 tail(const char *text, size_t length, size_t i, size_t remaining, U64 seed)
+	{
+		return remaining > 16 ?
+			tail(text, length, i + 16, remaining - 16, mix(read64(text, i) ^ eHashSecret1, read64(text, i + 8) ^ seed)) :
+			finish(read64(text, i + remaining - 16) ^ eHashSecret1, read64(text, i + remaining - 8) ^ seed, length);
+	}
+
+	constexpr U64 lanes(const char *text, size_t length, size_t i, size_t remaining, U64 seed, U64 lane1, U64 lane2)
+	{
+		return remaining > 48 ?
+			lanes(text, length, i + 48, remaining - 48,
+				mix(read64(text, i) ^ eHashSecret1, read64(text, i + 8) ^ seed),
+				mix(read64(text, i + 16) ^ eHashSecret2, read64(text, i + 24) ^ lane1),
+				mix(read64(text, i + 32) ^ eHashSecret3, read64(text, i + 40) ^ lane2)) :
+			tail(text, length, i, remaining, seed ^ lane1 ^ lane2);
+	}
+
+	constexpr U64 hashWithSeed(const char *text, size_t length, U64 seed)
+	{
+		return length <= 16 ? shortHash(text, length, seed, (length >> 3) << 2) :
+			length > 48 ? lanes(text, length, 0, length, seed, seed, seed) :
+			tail(text, length, 0, length, seed);
+	}
+}
+
+/// Hashes text the same way as hashBytes(text, length) with a seed of 0,
+/// but in a way that the compiler can evaluate, so that the hashes of
+/// literals can be constants. It is far slower than hashBytes when it runs
+/// at runtime, so only use it where the result is a constant expression.
+/// @param text The characters to hash.
+/// @param length The amount of characters. Texts of up to a few kilobytes
+///  stay within the recursion limits of compilers.
+/// @return The same hash as hashBytes(text, length).
+constexpr U64 compileTimeHash(const char *text, size_t length)
+{
+	return HashDetail::hashWithSeed(text, length,
+		HashDetail::mix(eHashSecret0, eHashSecret1) ^ static_cast<U64>(length));
+}
+
+#endif // _JBL_HASH_HPP_
@@ -27,6 +27,7 @@
 
 #include "lib.hpp"
 #include "string.hpp"
+#include "hash.hpp"
 
 template<class T>
 class HashFunction;
@@ -40,50 +41,226 @@ FORCE_INLINE size_t Hash(const T &t)
 	return b(t);
 }
 
+/// Combines the hashes of values into seed, in order.
+/// @see hashValues
+FORCE_INLINE size_t hashValuesFrom(size_t seed)
+{
+	return seed;
+}
+
+template<typename T, typename... Rest>
+FORCE_INLINE size_t hashValuesFrom(size_t seed, const T &first, const Rest&... rest)
+{
+	return hashValuesFrom(hashCombine(seed, Hash(first)), rest...);
+}
+
+/// Hashes any amount of values into one hash, in order. This is how a
+/// HashFunction for a struct is meant to be written:
+///
+///    template<>
+///    class HashFunction<RouteKey>
+///    {
+///    public:
+///       size_t operator()(const RouteKey &ref) const
+///       {
+///          return hashValues(ref.tenant, ref.shard, ref.id);
+///       }
+///    };
+///
+/// Every value is hashed with its own HashFunction.
+FORCE_INLINE size_t hashValues()
+{
+	return 0;
+}
+
+template<typename T, typename... Rest>
+FORCE_INLINE size_t hashValues(const T &first, const Rest&... rest)
+{
+	return hashValuesFrom(Hash(first), rest...);
+}
+
+/// Hashes an integer of up to 64 bits. The seed of the process is mixed in
+/// before the finalizer, so sequential and strided keys spread over every
+/// bit, and no two integers ever have the same 64 bit hash.
+FORCE_INLINE size_t hashInteger(U64 value)
+{
+	return static_cast<size_t>(finalizeHash64(value ^ hashSeed()));
+}
+
 template<class T>
 class HashFunction<T*>
 {
 public:
-	FORCE_INLINE size_t operator()(T *ref)
+	FORCE_INLINE size_t operator()(T *ref) const
+	{
+		// Pointers are hashed by their address. The low bits are always
+		// zero for aligned objects, which the finalizer takes care of.
+		return hashInteger(static_cast<U64>(reinterpret_cast<size_t>(ref)));
+	}
+};
+
+/// Hashes the characters of a string without the seed of the process. This
+/// is the first of the two stages of the hash of a String, and it is the
+/// same as compileTimeHash, so it can be compared against the hashes of
+/// literals, for example in a switch:
+///
+///    switch (stringHash(method))
+///    {
+///    case "GET"_hashed.textHash():
+///       if (method == "GET") ...
+///    }
+///
+/// Distinct strings can have the same hash, so a match still has to
+/// compare the text.
+FORCE_INLINE U64 stringHash(const StringView &text)
+{
+	return hashBytes(text.data(), static_cast<size_t>(text.length()));
+}
+
+/// A string whose text hash is already known, most of all a literal whose
+/// hash the compiler worked out. Dictionaries with String keys take it in
+/// place of a key, and skip hashing the characters.
+///
+///    static constexpr HashedKey kContentLength("content-length");
+///    headers.find(kContentLength);
+///    headers.find("content-length"_hashed);
+///
+/// Only a constexpr variable forces the compiler to hash at compile time,
+/// although optimizing compilers also do it for a temporary.
+///
+/// The seed of the process is only mixed in after the text hash, as it is
+/// not known until runtime. That second stage still spreads keys over the
+/// buckets differently in every process, but two strings that collide in
+/// the text hash collide with every seed. Finding such strings takes
+/// knowledge of the hash and real effort, but if untrusted clients pick the
+/// keys, prefer a keyed hash over the speed of precomputed hashes.
+class HashedKey
+{
+public:
+	/// Hashes a literal. This is explicit, so that a literal on its own
+	/// still means a plain lookup by StringView.
+	template<size_t N>
+	constexpr explicit HashedKey(const char (&text)[N]) :
+		mText(text),
+		mLength(N - 1),
+		mTextHash(compileTimeHash(text, N - 1))
+	{
+	}
+
+	/// Hashes the length characters of text.
+	constexpr HashedKey(const char *text, size_t length) :
+		mText(text),
+		mLength(length),
+		mTextHash(compileTimeHash(text, length))
+	{
+	}
+
+	/// Takes a text hash that was worked out before, which has to be the
+	/// stringHash of the view.
+	HashedKey(const StringView &text, U64 textHash) :
+		mText(text.data()),
+		mLength(static_cast<size_t>(text.length())),
+		mTextHash(textHash)
+	{
+		assert(textHash == stringHash(text));
+	}
+
+	/// Takes the text hash that a String has cached, so a long lived String
+	/// whose hash was cached is not hashed again however often it is looked
+	/// up.
+	explicit HashedKey(const String &text) :
+		mText(text.c_str()),
+		mLength(static_cast<size_t>(text.length())),
+		mTextHash(text.textHash())
+	{
+	}
+
+	/// Gets the characters as a view. The characters are not copied, so
+	/// they have to outlive the HashedKey.
+	FORCE_INLINE StringView view() const
+	{
+		return StringView(mText, static_cast<S32>(mLength));
+	}
+
+	/// Gets the hash of the characters, without the seed of the process.
+	constexpr U64 textHash() const
 	{
-		// Pointers just take the address.
-		return reinterpret_cast<size_t>(ref);
+		return mTextHash;
 	}
+
+private:
+	const char *mText;
+	size_t mLength;
+	U64 mTextHash;
 };
 
+/// Makes a HashedKey out of a literal: "content-length"_hashed.
+constexpr HashedKey operator"" _hashed(const char *text, size_t length)
+{
+	return HashedKey(text, length);
+}
+
+/// Hashes Strings in two stages. The characters are hashed without a seed,
+/// then the seed of the process is mixed into that hash. The first stage is
+/// what a HashedKey works out ahead of time.
 template<>
 class HashFunction<String>
 {
 public:
-	size_t operator()(String ref) const
+	/// Takes the text hash that the String has cached, so only the second
+	/// stage is worked out. A String without a cached hash is hashed whole,
+	/// the cache of a const String is never written.
+	FORCE_INLINE size_t operator()(const String &ref) const
 	{
-		// string hashing. Use 32bit FNV-1a algorithm. 
-		// The algorithm is in the public domain.
-
-		constexpr U32 offset_basis = 2166136261;
-		constexpr U32 FNV_prime = 16777619;
-
-		U32 hash = offset_basis;
-		S32 length = ref.length();
-		for (S32 i = 0; i < length; ++i)
-		{
-			hash = hash ^ static_cast<size_t>(ref[i]);
-			hash = hash * FNV_prime;
-		}
-		return static_cast<size_t>(hash);
+		return hashInteger(ref.textHash());
 	}
+
+	/// Hashes a String that may be changed, and caches its text hash so that
+	/// the String is never hashed again.
+	FORCE_INLINE size_t operator()(String &ref) const
+	{
+		return hashInteger(ref.textHash());
+	}
+
+	/// Hashes the characters of a view the same way as a String holding the
+	/// same characters, so that String keys can be looked up by a view.
+	FORCE_INLINE size_t operator()(const StringView &ref) const
+	{
+		return hashInteger(stringHash(ref));
+	}
+
+	/// Hashes a key whose characters are already hashed, which only costs
+	/// the second stage.
+	FORCE_INLINE size_t operator()(const HashedKey &ref) const
+	{
+		return hashInteger(ref.textHash());
+	}
+};
+
+/// The type that a Dictionary takes for lookups of a key type. Keys are
+/// looked up by themselves, except for String keys which are looked up by a
+/// StringView so that a lookup never has to construct a String.
+template<typename T>
+struct LookupKeyType
+{
+	typedef T Type;
 };
 
-#define IMPLEMENT_HASH_FUNCTION_PRIMITIVE(type) \
-template<>                                      \
-class HashFunction<type>                        \
-{                                               \
-public:                                         \
-	FORCE_INLINE size_t operator()(type ref)    \
-    {                                           \
-		/* Primitive types just return. */      \
-		return static_cast<size_t>(ref);        \
-	}                                           \
+template<>
+struct LookupKeyType<String>
+{
+	typedef StringView Type;
+};
+
+#define IMPLEMENT_HASH_FUNCTION_PRIMITIVE(type)   \
+template<>                                        \
+class HashFunction<type>                          \
+{                                                 \
+public:                                           \
+	FORCE_INLINE size_t operator()(type ref) const \
+	{                                              \
+		return hashInteger(static_cast<U64>(ref));  \
+	}                                              \
 }
 
 IMPLEMENT_HASH_FUNCTION_PRIMITIVE(bool);
@@ -95,7 +272,35 @@ IMPLEMENT_HASH_FUNCTION_PRIMITIVE(U8);
 IMPLEMENT_HASH_FUNCTION_PRIMITIVE(U16);
 IMPLEMENT_HASH_FUNCTION_PRIMITIVE(U32);
 IMPLEMENT_HASH_FUNCTION_PRIMITIVE(U64);
-IMPLEMENT_HASH_FUNCTION_PRIMITIVE(F32);
-IMPLEMENT_HASH_FUNCTION_PRIMITIVE(F64);
+
+/// Floats are hashed by their bits, so that values which only differ after
+/// the decimal point do not collide. -0.0 compares equal to 0.0, so it is
+/// turned into 0.0 first. NaN never compares equal to anything, so it does
+/// not matter what it hashes to.
+template<>
+class HashFunction<F32>
+{
+public:
+	FORCE_INLINE size_t operator()(F32 ref) const
+	{
+		const F32 normalized = ref == 0.0f ? 0.0f : ref;
+		U32 bits;
+		memcpy(&bits, &normalized, sizeof(bits));
+		return hashInteger(static_cast<U64>(bits));
+	}
+};
+
+template<>
+class HashFunction<F64>
+{
+public:
+	FORCE_INLINE size_t operator()(F64 ref) const
+	{
+		const F64 normalized = ref == 0.0 ? 0.0 : ref;
+		U64 bits;
+		memcpy(&bits, &normalized, sizeof(bits));
+		return hashInteger(bits);
+	}
+};
 
 #endif // _JBL_HASHFUNCTION_HPP_
\ No newline at end of file
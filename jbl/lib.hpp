@@ -25,6 +25,8 @@
 #ifndef _JBL_LIB_HPP_
 #define _JBL_LIB_HPP_
 
+#include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include "compiler.hpp"
 #include "types.hpp"
@@ -73,4 +75,68 @@ FORCE_INLINE S32 mCeil(F32 a)
 	return static_cast<S32>(a + 1.0f);
 }
 
+/// Counts the number of zero bits below the lowest set bit.
+/// @param mask The mask to scan. Must not be 0.
+/// @return The index of the lowest set bit within mask.
+FORCE_INLINE U32 countTrailingZeros(U32 mask)
+{
+	assert(mask != 0);
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return static_cast<U32>(index);
+#else
+	return static_cast<U32>(__builtin_ctz(mask));
+#endif
+}
+
+/// Counts the number of zero bits below the lowest set bit.
+/// @param mask The mask to scan. Must not be 0.
+/// @return The index of the lowest set bit within mask.
+FORCE_INLINE U32 countTrailingZeros(U64 mask)
+{
+	assert(mask != 0);
+#if defined(_MSC_VER) && defined(IS_64_BIT)
+	unsigned long index;
+	_BitScanForward64(&index, mask);
+	return static_cast<U32>(index);
+#elif defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, static_cast<U32>(mask)))
+		return static_cast<U32>(index);
+	_BitScanForward(&index, static_cast<U32>(mask >> 32));
+	return static_cast<U32>(index) + 32;
+#else
+	return static_cast<U32>(__builtin_ctzll(mask));
+#endif
+}
+
+/// Allocates memory whose address is a multiple of alignment.
+/// @param size The amount of bytes to allocate.
+/// @param alignment The alignment in bytes. Must be a power of two.
+/// @return The memory, which has to be freed with alignedFree.
+inline void* alignedMalloc(size_t size, size_t alignment)
+{
+	assert((alignment & (alignment - 1)) == 0);
+
+	// Over allocate, and keep the pointer that malloc gave back right in
+	// front of the aligned memory.
+	void *memory = malloc(size + alignment + sizeof(void*));
+	if (memory == nullptr)
+		return nullptr;
+
+	const size_t start = reinterpret_cast<size_t>(memory) + sizeof(void*);
+	void **aligned = reinterpret_cast<void**>((start + alignment - 1) & ~(alignment - 1));
+	aligned[-1] = memory;
+	return aligned;
+}
+
+/// Frees memory that came from alignedMalloc.
+/// @param memory The memory to free. May be nullptr.
+inline void alignedFree(void *memory)
+{
+	if (memory != nullptr)
+		free(static_cast<void**>(memory)[-1]);
+}
+
 #endif // _JBL_LIB_H_
@@ -0,0 +1,69 @@
+//-----------------------------------------------------------------------------
+// mappedFile.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_MAPPEDFILE_HPP_
+#define _JBL_MAPPEDFILE_HPP_
+
+#include <stddef.h>
+#include "types.hpp"
+
+/// Maps a whole file read-only into memory. The pages are loaded lazily by
+/// the operating system and are shared with every other process that maps
+/// the same file.
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile(MappedFile &&) = delete;
+
+	/// Maps a file, unmapping the previous one.
+	/// @param path The path of the file to map.
+	/// @return true if the file was mapped, false if it could not be opened
+	///  or is empty.
+	bool open(const char *path);
+
+	/// Unmaps the file. Every pointer into it becomes invalid.
+	void close();
+
+	/// Checks to see if a file is mapped.
+	/// @return true if a file is mapped, false otherwise.
+	bool isOpen() const { return mData != nullptr; }
+
+	/// Gets the contents of the file. The start is aligned to a page.
+	/// @return The first byte of the file, or nullptr if none is mapped.
+	const U8* data() const { return mData; }
+
+	/// Gets the size of the mapped file.
+	/// @return The size of the file in bytes.
+	size_t size() const { return mSize; }
+
+private:
+	const U8 *mData;
+	size_t mSize;
+};
+
+#endif // _JBL_MAPPEDFILE_HPP_
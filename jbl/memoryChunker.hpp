@@ -59,10 +59,18 @@ private:
 		}
 	};
 
+	/// A single T that has been given back to the chunker. The memory of
+	/// the T itself is used to link it into the free list.
+	struct FreeCell
+	{
+		FreeCell *next;
+	};
+
 public:
 	MemoryChunker() :
 		startPage{nullptr},
-		currentPage{nullptr} 
+		currentPage{nullptr},
+		freeList{nullptr}
 	{
 		startPage = new Page();
 		currentPage = startPage;
@@ -75,9 +83,11 @@ public:
 	{
 		startPage = ref.startPage;
 		currentPage = ref.currentPage;
+		freeList = ref.freeList;
 
 		ref.startPage = nullptr;
 		ref.currentPage = nullptr;
+		ref.freeList = nullptr;
 	}
 
 	~MemoryChunker()
@@ -105,9 +115,11 @@ public:
 
 			startPage = ref.startPage;
 			currentPage = ref.currentPage;
+			freeList = ref.freeList;
 
 			ref.startPage = nullptr;
 			ref.currentPage = nullptr;
+			ref.freeList = nullptr;
 		}
 		return *this;
 	}
@@ -123,25 +135,140 @@ public:
 			// the page size.
 		}
 
-		if (size >= currentPage->freespaceLeft)
+		return new (allocMemory(size)) T;
+	}
+
+	/// Constructs a single T with the given constructor arguments. Memory
+	/// that was given back with destroy is reused before any new memory is
+	/// taken from the pages.
+	template<typename... Args>
+	T* construct(Args&&... args)
+	{
+		void *mem;
+		if (freeList != nullptr)
 		{
-			// Allocate on new page.
-			Page *newPage = new Page();
-			currentPage->next = newPage;
-			currentPage = newPage;
+			mem = freeList;
+			freeList = freeList->next;
+		}
+		else
+		{
+			mem = allocMemory(sizeof(T));
+		}
+		return new (mem) T(static_cast<Args&&>(args)...);
+	}
+
+	/// Destroys a single T and puts its memory on the free list so that the
+	/// next construct can reuse it.
+	void destroy(T *ptr)
+	{
+		static_assert(sizeof(T) >= sizeof(FreeCell), "T is too small to be linked into the free list.");
+
+		ptr->~T();
+		FreeCell *cell = reinterpret_cast<FreeCell*>(ptr);
+		cell->next = freeList;
+		freeList = cell;
+	}
+
+	/// Marks every page as empty again without giving the pages back.
+	/// @note Destructors are not called. Anything that is still alive inside
+	///  of the chunker has to be destroyed by the caller first.
+	void reset()
+	{
+		for (Page *page = startPage; page != nullptr; page = page->next)
+			page->freespaceLeft = getFreespace();
+		currentPage = startPage;
+		freeList = nullptr;
+	}
+
+	/// Takes over every page and every free T of other, so that the T's that
+	/// other constructed can be destroyed through this chunker. other is
+	/// left empty, with a single new page.
+	/// @param other The chunker to take the memory of.
+	void absorb(MemoryChunker &other)
+	{
+		assert(this != &other);
+
+		// The pages go in front, where only pages that are in use are.
+		// Pages after the current page have to stay free for allocMemory.
+		Page *last = other.startPage;
+		while (last->next != nullptr)
+			last = last->next;
+		last->next = startPage;
+		startPage = other.startPage;
+
+		if (other.freeList != nullptr)
+		{
+			FreeCell *lastFree = other.freeList;
+			while (lastFree->next != nullptr)
+				lastFree = lastFree->next;
+			lastFree->next = freeList;
+			freeList = other.freeList;
 		}
-		
-		// Allocate.
-		const U32 offset = getFreespace() - static_cast<U32>(currentPage->freespaceLeft);
-		void *mem = &currentPage->memory[offset];
-		currentPage->freespaceLeft -= static_cast<S32>(size);
 
-		return new (mem) T;
+		other.startPage = new Page();
+		other.currentPage = other.startPage;
+		other.freeList = nullptr;
+	}
+
+	/// Gets the amount of pages that the chunker has allocated.
+	/// @return The amount of pages.
+	S32 getPageCount() const
+	{
+		S32 count = 0;
+		for (Page *page = startPage; page != nullptr; page = page->next)
+			++count;
+		return count;
+	}
+
+	/// Gets the amount of memory that the pages of the chunker take up.
+	/// @return The size of all pages in bytes.
+	size_t getAllocatedBytes() const
+	{
+		return static_cast<size_t>(getPageCount()) * sizeof(Page);
+	}
+
+	/// Gets the amount of T's that were given back with destroy and are
+	/// waiting to be reused.
+	/// @return The length of the free list.
+	S32 getFreeCount() const
+	{
+		S32 count = 0;
+		for (FreeCell *cell = freeList; cell != nullptr; cell = cell->next)
+			++count;
+		return count;
 	}
 
 private:
 	Page *startPage;
 	Page *currentPage;
+	FreeCell *freeList;
+
+	/// Takes size bytes out of the current page, moving on to the next page
+	/// when the current one is full.
+	void* allocMemory(U32 size)
+	{
+		if (size >= currentPage->freespaceLeft)
+		{
+			if (currentPage->next != nullptr)
+			{
+				// Reuse a page that was kept around by reset.
+				currentPage = currentPage->next;
+			}
+			else
+			{
+				// Allocate on new page.
+				Page *newPage = new Page();
+				currentPage->next = newPage;
+				currentPage = newPage;
+			}
+		}
+
+		// Allocate.
+		const U32 offset = getFreespace() - static_cast<U32>(currentPage->freespaceLeft);
+		void *mem = &currentPage->memory[offset];
+		currentPage->freespaceLeft -= static_cast<S32>(size);
+		return mem;
+	}
 };
 
 #endif // _JBL_MEMORYCHUNKER_H_
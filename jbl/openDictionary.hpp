@@ -0,0 +1,616 @@
+//-----------------------------------------------------------------------------
+// openDictionary.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_OPENDICTIONARY_HPP_
+#define _JBL_OPENDICTIONARY_HPP_
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include "typetraits.hpp"
+#include "hashFunction.hpp"
+
+/// An open addressing hash table in the style of a Swiss table.
+///
+/// Every slot owns a single control byte. The byte is either empty, deleted,
+/// or holds 7 bits of the hash of the key that lives in the slot. Slots are
+/// grouped 16 at a time so that a whole group of control bytes can be
+/// matched against a hash tag with a single SSE2 compare. Keys are only
+/// compared for slots whose tag matched, so a miss rarely touches the
+/// key/value storage at all.
+///
+/// Once 7/8 of the slots are taken, deleted slots included, the table is
+/// rebuilt. It keeps its size if most of the taken slots were deleted keys,
+/// and doubles otherwise.
+template<typename DictionaryKey, typename DictionaryValue, class Hash = HashFunction<DictionaryKey>>
+class OpenDictionary
+{
+public:
+	struct KVPair
+	{
+		DictionaryKey key;
+		DictionaryValue value;
+	};
+
+private:
+	enum Constants
+	{
+		eGroupWidth = 16,
+
+		// Maximum load of the table is eMaxLoadNumerator / eMaxLoadDenominator.
+		eMaxLoadNumerator = 7,
+		eMaxLoadDenominator = 8
+	};
+
+	/// Control byte values. Anything positive is a full slot and holds the
+	/// 7 bit tag of the hash.
+	enum Control : S8
+	{
+		eEmpty = -128,
+		eDeleted = -2
+	};
+
+	/// A window of eGroupWidth control bytes that are matched together.
+	class Group
+	{
+	public:
+		FORCE_INLINE explicit Group(const S8 *control)
+		{
+#ifdef SSE_INTRINSICS
+			mControl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+#else
+			mControl = control;
+#endif
+		}
+
+		/// @return A bitmask of the slots within the group that hold tag.
+		FORCE_INLINE U32 match(S8 tag) const
+		{
+#ifdef SSE_INTRINSICS
+			return static_cast<U32>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(tag), mControl)));
+#else
+			U32 mask = 0;
+			for (S32 i = 0; i < eGroupWidth; ++i)
+			{
+				if (mControl[i] == tag)
+					mask |= 1U << i;
+			}
+			return mask;
+#endif
+		}
+
+		/// @return A bitmask of the slots within the group that are empty.
+		FORCE_INLINE U32 matchEmpty() const
+		{
+			return match(eEmpty);
+		}
+
+		/// @return A bitmask of the slots within the group that are empty or
+		///  deleted. Both have their sign bit set.
+		FORCE_INLINE U32 matchEmptyOrDeleted() const
+		{
+#ifdef SSE_INTRINSICS
+			return static_cast<U32>(_mm_movemask_epi8(mControl));
+#else
+			U32 mask = 0;
+			for (S32 i = 0; i < eGroupWidth; ++i)
+			{
+				if (mControl[i] < 0)
+					mask |= 1U << i;
+			}
+			return mask;
+#endif
+		}
+
+		/// @return A bitmask of the slots within the group that hold data.
+		FORCE_INLINE U32 matchFull() const
+		{
+			return ~matchEmptyOrDeleted() & 0xFFFF;
+		}
+
+	private:
+#ifdef SSE_INTRINSICS
+		__m128i mControl;
+#else
+		const S8 *mControl;
+#endif
+	};
+
+public:
+	/// A class that is responsible for iterating over an OpenDictionary.
+	/// It performs forward iteration at O(n) time.
+	/// @see CIterator
+	class Iterator
+	{
+		friend class OpenDictionary<DictionaryKey, DictionaryValue, Hash>;
+	public:
+		Iterator(OpenDictionary *dictionary, size_t slot)
+		{
+			mDictionary = dictionary;
+			mSlot = slot;
+			skipEmptySlots();
+		}
+
+		/// Incriments the iterator to advance it to access the next element.
+		/// @return The current iterator.
+		Iterator& operator++()
+		{
+			assert(mSlot < mDictionary->mCapacity);
+			++mSlot;
+			skipEmptySlots();
+			return *this;
+		}
+
+		/// Compares if two iterators are at the same position.
+		/// @param it The other iterator to check.
+		/// @return true if both iterators are at the same position, false
+		///  otherwise.
+		bool operator!=(const Iterator &it) const
+		{
+			assert(mDictionary == it.mDictionary);
+			return mSlot != it.mSlot;
+		}
+
+		/// Dereferences the current element at the current iterator position.
+		/// @return The key/value pair stored at the current position.
+		KVPair& operator*() const
+		{
+			assert(mSlot < mDictionary->mCapacity);
+			return mDictionary->mSlots[mSlot];
+		}
+
+		KVPair* operator->() const
+		{
+			assert(mSlot < mDictionary->mCapacity);
+			return &mDictionary->mSlots[mSlot];
+		}
+
+	private:
+		OpenDictionary *mDictionary;
+		size_t mSlot;
+
+		/// Moves forward to the next full slot, a group at a time.
+		void skipEmptySlots()
+		{
+			mSlot = mDictionary->findNextFullSlot(mSlot);
+		}
+	};
+
+	/// A class that is responsible for iterating over an OpenDictionary.
+	/// It performs forward iteration at O(n) time.
+	/// Unlike Iterator, this version is a constant iterator over the OpenDictionary.
+	/// @see Iterator
+	class CIterator
+	{
+		friend class OpenDictionary<DictionaryKey, DictionaryValue, Hash>;
+	public:
+		CIterator(const OpenDictionary *dictionary, size_t slot)
+		{
+			mDictionary = dictionary;
+			mSlot = slot;
+			skipEmptySlots();
+		}
+
+		/// Incriments the iterator to advance it to access the next element.
+		/// @return The current iterator.
+		const CIterator& operator++()
+		{
+			assert(mSlot < mDictionary->mCapacity);
+			++mSlot;
+			skipEmptySlots();
+			return *this;
+		}
+
+		/// Compares if two iterators are at the same position.
+		/// @param it The other iterator to check.
+		/// @return true if both iterators are at the same position, false
+		///  otherwise.
+		bool operator!=(const CIterator &it) const
+		{
+			assert(mDictionary == it.mDictionary);
+			return mSlot != it.mSlot;
+		}
+
+		/// Dereferences the current element at the current iterator position.
+		/// @return The key/value pair stored at the current position.
+		const KVPair& operator*() const
+		{
+			assert(mSlot < mDictionary->mCapacity);
+			return mDictionary->mSlots[mSlot];
+		}
+
+		const KVPair* operator->() const
+		{
+			assert(mSlot < mDictionary->mCapacity);
+			return &mDictionary->mSlots[mSlot];
+		}
+
+	private:
+		const OpenDictionary *mDictionary;
+		size_t mSlot;
+
+		/// Moves forward to the next full slot, a group at a time.
+		void skipEmptySlots()
+		{
+			mSlot = mDictionary->findNextFullSlot(mSlot);
+		}
+	};
+
+public:
+	/// Creates an OpenDictionary.
+	/// @param capacity The amount of elements the table should be able to hold
+	///  before it has to grow.
+	explicit OpenDictionary(S32 capacity = 0)
+	{
+		static_assert(!TypeTraits::IsSame<DictionaryKey, const char*>::value, "You cannot use const char* as a type for your dictionary key type! Please use String instead.");
+		static_assert(!TypeTraits::IsSame<DictionaryValue, const char*>::value, "You cannot use const char* as a type for your dictionary value type! Please use String instead.");
+
+		allocateTable(groupCountForCapacity(static_cast<size_t>(mMax(capacity, 0))));
+	}
+
+	OpenDictionary(const OpenDictionary &) = delete;
+	OpenDictionary& operator=(const OpenDictionary &) = delete;
+
+	OpenDictionary(OpenDictionary &&dict)
+	{
+		takeTable(dict);
+	}
+
+	~OpenDictionary()
+	{
+		destroyTable();
+	}
+
+	OpenDictionary& operator=(OpenDictionary &&dict)
+	{
+		if (this != &dict)
+		{
+			destroyTable();
+			takeTable(dict);
+		}
+		return *this;
+	}
+
+	DictionaryValue& operator[](const DictionaryKey &key)
+	{
+		bool inserted;
+		size_t slot = findOrPrepareInsert(key, inserted);
+		if (inserted)
+			new (&mSlots[slot]) KVPair{key, DictionaryValue()};
+		return mSlots[slot].value;
+	}
+
+	/// Inserts a key/value pair into the dictionary.
+	/// @param key The key to insert.
+	/// @param value The value to insert.
+	/// @return true if the pair was inserted, false if the key was already
+	///  present. An existing value is left untouched.
+	bool insert(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		bool inserted;
+		size_t slot = findOrPrepareInsert(key, inserted);
+		if (inserted)
+			new (&mSlots[slot]) KVPair{key, value};
+		return inserted;
+	}
+
+	Iterator find(const DictionaryKey &key)
+	{
+		size_t slot = findSlot(key, mixHash(key));
+		return Iterator(this, slot);
+	}
+
+	CIterator find(const DictionaryKey &key) const
+	{
+		size_t slot = findSlot(key, mixHash(key));
+		return CIterator(this, slot);
+	}
+
+	/// Erases the element at the iterator position.
+	/// @param iterator The position of the element to erase.
+	/// @return An iterator to the element following the erased element.
+	Iterator erase(Iterator iterator)
+	{
+		size_t slot = iterator.mSlot;
+		assert(slot < mCapacity && mControl[slot] >= 0);
+
+		mSlots[slot].~KVPair();
+		--mCount;
+
+		// If the group still has an empty slot, every probe that reaches this
+		// group stops here anyway, so the slot can go back to being empty.
+		// Otherwise leave a tombstone so that probes keep on going.
+		size_t groupStart = slot & ~static_cast<size_t>(eGroupWidth - 1);
+		if (Group(mControl + groupStart).matchEmpty() != 0)
+		{
+			mControl[slot] = eEmpty;
+			++mGrowthLeft;
+		}
+		else
+		{
+			mControl[slot] = eDeleted;
+		}
+
+		return Iterator(this, slot + 1);
+	}
+
+	/// Gets the amount of elements within the dictionary.
+	/// @return The amount of elements in the dictionary.
+	FORCE_INLINE S32 count() const
+	{
+		return static_cast<S32>(mCount);
+	}
+
+	/// Gets the amount of slots allocated by the dictionary.
+	/// @return The amount of slots in the dictionary.
+	FORCE_INLINE S32 capacity() const
+	{
+		return static_cast<S32>(mCapacity);
+	}
+
+	/// Grabs an iterator at the beginning of the OpenDictionary.
+	/// @return an iterator at the beginning of the OpenDictionary.
+	FORCE_INLINE Iterator begin()
+	{
+		return Iterator(this, 0);
+	}
+
+	/// Grabs an iterator at the end of the OpenDictionary.
+	/// @return an iterator at the end of the OpenDictionary.
+	FORCE_INLINE Iterator end()
+	{
+		return Iterator(this, mCapacity);
+	}
+
+	/// Grabs a constant iterator at the beginning of the OpenDictionary.
+	/// @return a constant iterator at the beginning of the OpenDictionary.
+	FORCE_INLINE CIterator begin() const
+	{
+		return CIterator(this, 0);
+	}
+
+	/// Grabs a constant iterator at the end of the OpenDictionary.
+	/// @return a constant iterator at the end of the OpenDictionary.
+	FORCE_INLINE CIterator end() const
+	{
+		return CIterator(this, mCapacity);
+	}
+
+private:
+	S8 *mControl;
+	KVPair *mSlots;
+	size_t mCapacity;
+	size_t mGroupMask;
+	U32 mGroupShift;
+	size_t mCount;
+	size_t mGrowthLeft;
+
+	/// Spreads the hash over all 64 bits. The tag is taken from the top 7
+	/// bits and the group from the bits right below it, so that the two
+	/// never share bits.
+	template<typename T>
+	FORCE_INLINE U64 mixHash(const T &ref) const
+	{
+		Hash hash;
+		return static_cast<U64>(hash(ref)) * 0x9E3779B97F4A7C15ULL;
+	}
+
+	FORCE_INLINE static S8 tagFromHash(U64 mixed)
+	{
+		return static_cast<S8>(mixed >> 57);
+	}
+
+	FORCE_INLINE size_t groupFromHash(U64 mixed) const
+	{
+		return static_cast<size_t>(mixed >> mGroupShift) & mGroupMask;
+	}
+
+	static size_t groupCountForCapacity(size_t capacity)
+	{
+		size_t slots = (capacity * eMaxLoadDenominator + eMaxLoadNumerator - 1) / eMaxLoadNumerator;
+		size_t groups = 1;
+		while (groups * eGroupWidth < slots)
+			groups <<= 1;
+		return groups;
+	}
+
+	/// Finds the slot that holds key.
+	/// @return The slot index, or mCapacity if the key is not present.
+	size_t findSlot(const DictionaryKey &key, U64 mixed) const
+	{
+		S8 tag = tagFromHash(mixed);
+		size_t group = groupFromHash(mixed);
+
+		// Triangular probing over a power of 2 amount of groups visits
+		// every group exactly once.
+		for (size_t probe = 1; ; ++probe)
+		{
+			const size_t groupStart = group * eGroupWidth;
+			Group g(mControl + groupStart);
+			for (U32 mask = g.match(tag); mask != 0; mask &= mask - 1)
+			{
+				size_t slot = groupStart + countTrailingZeros(mask);
+				if (equals(mSlots[slot].key, key))
+					return slot;
+			}
+
+			// An empty slot ends the probe sequence.
+			if (g.matchEmpty() != 0)
+				return mCapacity;
+
+			group = (group + probe) & mGroupMask;
+		}
+	}
+
+	/// Finds the first empty or deleted slot along the probe sequence.
+	size_t findFirstNonFull(U64 mixed) const
+	{
+		size_t group = groupFromHash(mixed);
+		for (size_t probe = 1; ; ++probe)
+		{
+			U32 mask = Group(mControl + group * eGroupWidth).matchEmptyOrDeleted();
+			if (mask != 0)
+				return group * eGroupWidth + countTrailingZeros(mask);
+
+			group = (group + probe) & mGroupMask;
+		}
+	}
+
+	/// Looks up key, and claims a slot for it if it is not present.
+	/// The caller is responsible for constructing the pair when inserted
+	/// is set to true.
+	size_t findOrPrepareInsert(const DictionaryKey &key, bool &inserted)
+	{
+		U64 mixed = mixHash(key);
+		size_t slot = findSlot(key, mixed);
+		if (slot != mCapacity)
+		{
+			inserted = false;
+			return slot;
+		}
+
+		slot = findFirstNonFull(mixed);
+		if (mGrowthLeft == 0 && mControl[slot] != eDeleted)
+		{
+			// If most of the used slots are tombstones, rehashing at the same
+			// size is enough to clean them up. Otherwise grow.
+			size_t maxLoad = mCapacity * eMaxLoadNumerator / eMaxLoadDenominator;
+			if (mCount * 2 <= maxLoad)
+				resize(mGroupMask + 1);
+			else
+				resize((mGroupMask + 1) * 2);
+			slot = findFirstNonFull(mixed);
+		}
+
+		if (mControl[slot] == eEmpty)
+			--mGrowthLeft;
+		mControl[slot] = tagFromHash(mixed);
+		++mCount;
+
+		inserted = true;
+		return slot;
+	}
+
+	/// Finds the first full slot at or after slot.
+	/// @return The slot index, or mCapacity if there are no more full slots.
+	size_t findNextFullSlot(size_t slot) const
+	{
+		while (slot < mCapacity)
+		{
+			const size_t groupStart = slot & ~static_cast<size_t>(eGroupWidth - 1);
+			U32 mask = Group(mControl + groupStart).matchFull() >> (slot - groupStart);
+			if (mask != 0)
+				return slot + countTrailingZeros(mask);
+
+			slot = groupStart + eGroupWidth;
+		}
+		return mCapacity;
+	}
+
+	void allocateTable(size_t groupCount)
+	{
+		mCapacity = groupCount * eGroupWidth;
+		mGroupMask = groupCount - 1;
+
+		// The group index is taken from the bits right under the 7 bit tag.
+		U32 groupBits = 0;
+		while ((static_cast<size_t>(1) << groupBits) < groupCount)
+			++groupBits;
+		mGroupShift = 57 - groupBits;
+
+		mControl = static_cast<S8*>(malloc(mCapacity));
+		memset(mControl, eEmpty, mCapacity);
+		mSlots = static_cast<KVPair*>(malloc(mCapacity * sizeof(KVPair)));
+
+		mCount = 0;
+		mGrowthLeft = mCapacity * eMaxLoadNumerator / eMaxLoadDenominator;
+	}
+
+	/// Rebuilds the table with groupCount groups, moving every element over.
+	/// This also drops every tombstone.
+	void resize(size_t groupCount)
+	{
+		S8 *oldControl = mControl;
+		KVPair *oldSlots = mSlots;
+		size_t oldCapacity = mCapacity;
+
+		allocateTable(groupCount);
+
+		for (size_t i = 0; i < oldCapacity; ++i)
+		{
+			if (oldControl[i] < 0)
+				continue;
+
+			KVPair &pair = oldSlots[i];
+			U64 mixed = mixHash(pair.key);
+			size_t slot = findFirstNonFull(mixed);
+			mControl[slot] = tagFromHash(mixed);
+			new (&mSlots[slot]) KVPair{move_cast(pair.key), move_cast(pair.value)};
+			pair.~KVPair();
+
+			++mCount;
+			--mGrowthLeft;
+		}
+
+		free(oldControl);
+		free(oldSlots);
+	}
+
+	void destroyTable()
+	{
+		if (mControl == nullptr)
+			return;
+
+		for (size_t i = 0; i < mCapacity; ++i)
+		{
+			if (mControl[i] >= 0)
+				mSlots[i].~KVPair();
+		}
+
+		free(mControl);
+		free(mSlots);
+		mControl = nullptr;
+		mSlots = nullptr;
+	}
+
+	void takeTable(OpenDictionary &dict)
+	{
+		mControl = dict.mControl;
+		mSlots = dict.mSlots;
+		mCapacity = dict.mCapacity;
+		mGroupMask = dict.mGroupMask;
+		mGroupShift = dict.mGroupShift;
+		mCount = dict.mCount;
+		mGrowthLeft = dict.mGrowthLeft;
+
+		dict.mControl = nullptr;
+		dict.mSlots = nullptr;
+		dict.mCapacity = 0;
+		dict.mCount = 0;
+		dict.mGrowthLeft = 0;
+	}
+};
+
+#endif // _JBL_OPENDICTIONARY_HPP_
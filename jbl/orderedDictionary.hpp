@@ -0,0 +1,604 @@
+//-----------------------------------------------------------------------------
+// orderedDictionary.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_ORDEREDDICTIONARY_HPP_
+#define _JBL_ORDEREDDICTIONARY_HPP_
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include "lib.hpp"
+#include "hashFunction.hpp"
+#include "dictionary.hpp"
+
+/// A hash map that remembers the order its keys were inserted in.
+///
+/// The pairs live in one dense array in insertion order, together with the
+/// hash of their key. Lookups go through a separate open addressing index
+/// that only holds positions into that array. The index is tiny: its slots
+/// are 8, 16 or 32 bits wide, whichever is the smallest that can address
+/// every entry, so a table of up to 254 entries has an index of a few
+/// hundred bytes. Iteration is a linear sweep over the entry array and
+/// never touches the index at all.
+///
+/// Erasing leaves a hole in the entry array that iteration steps over. The
+/// holes are squeezed out the next time the array grows. Growing moves the
+/// entries and rebuilds the index from the stored hashes, so keys are never
+/// hashed twice.
+template<typename DictionaryKey, typename DictionaryValue, class Hash = HashFunction<DictionaryKey>>
+class OrderedDictionary
+{
+public:
+	/// The type that keys are looked up by. For String keys this is a
+	/// StringView, the same as for Dictionary.
+	typedef typename LookupKeyType<DictionaryKey>::Type LookupKey;
+
+	/// A key/value pair within the OrderedDictionary. The key of a pair that
+	/// belongs to a dictionary must never be modified.
+	struct KVPair
+	{
+		DictionaryKey key;
+		DictionaryValue value;
+	};
+
+private:
+	struct Entry
+	{
+		KVPair pair;
+
+		/// The hash of the key, or eErasedHash if the entry was erased.
+		size_t hash;
+	};
+
+	enum Constants
+	{
+		eMinCapacity = 8,
+
+		// Index slots hold the position of an entry plus one, so that zero
+		// can mean empty. The largest value of a slot marks a slot whose
+		// entry was erased.
+		eEmptySlot = 0
+	};
+
+	static const size_t eErasedHash = ~static_cast<size_t>(0);
+
+public:
+	/// A class that is responsible for iterating over an OrderedDictionary
+	/// in insertion order. It performs forward iteration at O(n) time.
+	/// @see CIterator
+	class Iterator
+	{
+		friend class OrderedDictionary;
+	public:
+		/// Incriments the iterator to advance it to access the next element.
+		/// @return The current iterator.
+		Iterator& operator++()
+		{
+			++mEntry;
+			skipErased();
+			return *this;
+		}
+
+		bool operator==(const Iterator &it) const
+		{
+			return mEntry == it.mEntry;
+		}
+
+		bool operator!=(const Iterator &it) const
+		{
+			return mEntry != it.mEntry;
+		}
+
+		/// Dereferences the current element at the current iterator position.
+		/// @return A reference to the key/value pair at the current position.
+		KVPair& operator*() const
+		{
+			assert(mEntry < mEnd);
+			return mEntry->pair;
+		}
+
+		KVPair* operator->() const
+		{
+			assert(mEntry < mEnd);
+			return &mEntry->pair;
+		}
+
+	private:
+		Entry *mEntry;
+		Entry *mEnd;
+
+		Iterator(Entry *entry, Entry *end)
+		{
+			mEntry = entry;
+			mEnd = end;
+			skipErased();
+		}
+
+		FORCE_INLINE void skipErased()
+		{
+			while (mEntry != mEnd && mEntry->hash == eErasedHash)
+				++mEntry;
+		}
+	};
+
+	/// A class that is responsible for iterating over an OrderedDictionary
+	/// in insertion order. Unlike Iterator, this version is a constant
+	/// iterator.
+	/// @see Iterator
+	class CIterator
+	{
+		friend class OrderedDictionary;
+	public:
+		/// Incriments the iterator to advance it to access the next element.
+		/// @return The current iterator.
+		CIterator& operator++()
+		{
+			++mEntry;
+			skipErased();
+			return *this;
+		}
+
+		bool operator==(const CIterator &it) const
+		{
+			return mEntry == it.mEntry;
+		}
+
+		bool operator!=(const CIterator &it) const
+		{
+			return mEntry != it.mEntry;
+		}
+
+		/// Dereferences the current element at the current iterator position.
+		/// @return A reference to the key/value pair at the current position.
+		const KVPair& operator*() const
+		{
+			assert(mEntry < mEnd);
+			return mEntry->pair;
+		}
+
+		const KVPair* operator->() const
+		{
+			assert(mEntry < mEnd);
+			return &mEntry->pair;
+		}
+
+	private:
+		const Entry *mEntry;
+		const Entry *mEnd;
+
+		CIterator(const Entry *entry, const Entry *end)
+		{
+			mEntry = entry;
+			mEnd = end;
+			skipErased();
+		}
+
+		FORCE_INLINE void skipErased()
+		{
+			while (mEntry != mEnd && mEntry->hash == eErasedHash)
+				++mEntry;
+		}
+	};
+
+	/// The result of an insertion. iterator points at the element with the
+	/// key, whether it was just inserted or was already there.
+	struct InsertResult
+	{
+		Iterator iterator;
+		bool inserted;
+	};
+
+	/// Creates an OrderedDictionary.
+	/// @param capacity The amount of elements to make room for up front.
+	explicit OrderedDictionary(S32 capacity = 0)
+	{
+		initEmpty();
+		reserve(capacity);
+	}
+
+	OrderedDictionary(const OrderedDictionary &) = delete;
+	OrderedDictionary& operator=(const OrderedDictionary &) = delete;
+
+	OrderedDictionary(OrderedDictionary &&dict)
+	{
+		takeArrays(dict);
+	}
+
+	OrderedDictionary& operator=(OrderedDictionary &&dict)
+	{
+		if (this != &dict)
+		{
+			destroyEntries();
+			free(mEntries);
+			free(mIndex);
+			takeArrays(dict);
+		}
+		return *this;
+	}
+
+	~OrderedDictionary()
+	{
+		destroyEntries();
+		free(mEntries);
+		free(mIndex);
+	}
+
+	/// Gets the value of key, inserting a default constructed value at the
+	/// end if the key is not within the dictionary yet.
+	DictionaryValue& operator[](const LookupKey &key)
+	{
+		const size_t keyHash = hashKey(key);
+		S32 position = findEntry(key, keyHash);
+		if (position < 0)
+			position = appendEntry(keyHash, DictionaryKey(key), DictionaryValue());
+		return mEntries[position].pair.value;
+	}
+
+	/// Inserts a key/value pair at the end if the key is not within the
+	/// dictionary yet. A key that is already there keeps its position.
+	/// @return The position of the element with the key, and whether or not
+	///  it was inserted.
+	InsertResult insert(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		const size_t keyHash = hashKey(key);
+		const S32 position = findEntry(key, keyHash);
+		if (position >= 0)
+			return InsertResult{iteratorAt(position), false};
+
+		return InsertResult{iteratorAt(appendEntry(keyHash, key, value)), true};
+	}
+
+	/// Inserts a key/value pair at the end, or assigns value to the existing
+	/// element if the key is already within the dictionary. Assigning does
+	/// not move the element.
+	/// @return The position of the element with the key, and whether or not
+	///  it was inserted.
+	InsertResult insertOrAssign(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		const size_t keyHash = hashKey(key);
+		const S32 position = findEntry(key, keyHash);
+		if (position >= 0)
+		{
+			mEntries[position].pair.value = value;
+			return InsertResult{iteratorAt(position), false};
+		}
+
+		return InsertResult{iteratorAt(appendEntry(keyHash, key, value)), true};
+	}
+
+	Iterator find(const LookupKey &key)
+	{
+		const S32 position = findEntry(key, hashKey(key));
+		return position >= 0 ? iteratorAt(position) : end();
+	}
+
+	CIterator find(const LookupKey &key) const
+	{
+		const S32 position = findEntry(key, hashKey(key));
+		return position >= 0 ? CIterator(mEntries + position, mEntries + mUsed) : end();
+	}
+
+	/// Checks to see if the dictionary contains key.
+	/// @param key The key to look for.
+	/// @return true if the key is within the dictionary, false otherwise.
+	bool contains(const LookupKey &key) const
+	{
+		return findEntry(key, hashKey(key)) >= 0;
+	}
+
+	/// Erases the element at the iterator position. The order of the other
+	/// elements does not change, and no other iterator is invalidated.
+	/// @param iterator The position of the element to erase.
+	/// @return An iterator to the element following the erased element.
+	Iterator erase(Iterator iterator)
+	{
+		Entry *entry = iterator.mEntry;
+		assert(entry >= mEntries && entry < mEntries + mUsed && entry->hash != eErasedHash);
+
+		const S32 position = static_cast<S32>(entry - mEntries);
+		switch (mSlotBytes)
+		{
+		case 1: eraseSlot(reinterpret_cast<U8*>(mIndex), entry->hash, position); break;
+		case 2: eraseSlot(reinterpret_cast<U16*>(mIndex), entry->hash, position); break;
+		default: eraseSlot(reinterpret_cast<U32*>(mIndex), entry->hash, position); break;
+		}
+
+		entry->pair.~KVPair();
+		entry->hash = eErasedHash;
+		--mCount;
+		return Iterator(entry + 1, mEntries + mUsed);
+	}
+
+	/// Removes every element from the dictionary. The memory is kept.
+	void clear()
+	{
+		destroyEntries();
+		if (mIndex != nullptr)
+			memset(mIndex, 0, mIndexSize * mSlotBytes);
+		mCount = 0;
+		mUsed = 0;
+	}
+
+	/// Makes sure that the dictionary can hold at least count elements
+	/// without growing. This also squeezes out the holes left by erasing.
+	void reserve(S32 count)
+	{
+		if (count > mCapacity)
+			resize(count);
+	}
+
+	/// Gets the amount of elements within the dictionary.
+	/// @return The amount of elements in the dictionary.
+	FORCE_INLINE S32 count() const
+	{
+		return mCount;
+	}
+
+	/// Gets the amount of elements the dictionary has memory for.
+	/// @return The capacity of the dictionary.
+	FORCE_INLINE S32 capacity() const
+	{
+		return mCapacity;
+	}
+
+	/// Gets the width of an index slot, which depends on the capacity.
+	/// @return 1, 2 or 4 bytes.
+	FORCE_INLINE S32 indexSlotBytes() const
+	{
+		return mSlotBytes;
+	}
+
+	/// Grabs an iterator at the oldest element of the OrderedDictionary.
+	FORCE_INLINE Iterator begin()
+	{
+		return Iterator(mEntries, mEntries + mUsed);
+	}
+
+	/// Grabs an iterator at the end of the OrderedDictionary.
+	FORCE_INLINE Iterator end()
+	{
+		return Iterator(mEntries + mUsed, mEntries + mUsed);
+	}
+
+	/// Grabs a constant iterator at the oldest element of the
+	/// OrderedDictionary.
+	FORCE_INLINE CIterator begin() const
+	{
+		return CIterator(mEntries, mEntries + mUsed);
+	}
+
+	/// Grabs a constant iterator at the end of the OrderedDictionary.
+	FORCE_INLINE CIterator end() const
+	{
+		return CIterator(mEntries + mUsed, mEntries + mUsed);
+	}
+
+private:
+	/// The entries in insertion order. Erased entries stay as holes until
+	/// the array is resized.
+	Entry *mEntries;
+
+	/// The open addressing index, an array of mIndexSize slots that are
+	/// mSlotBytes wide each.
+	void *mIndex;
+	size_t mIndexSize;
+	S32 mSlotBytes;
+
+	/// Picks the first index slot for a hash.
+	FibonacciBuckets mBuckets;
+
+	/// The amount of live elements.
+	S32 mCount;
+
+	/// The amount of entries in use, holes included.
+	S32 mUsed;
+
+	S32 mCapacity;
+
+	void initEmpty()
+	{
+		mEntries = nullptr;
+		mIndex = nullptr;
+		mIndexSize = 0;
+		mSlotBytes = 1;
+		mCount = 0;
+		mUsed = 0;
+		mCapacity = 0;
+	}
+
+	void takeArrays(OrderedDictionary &dict)
+	{
+		mEntries = dict.mEntries;
+		mIndex = dict.mIndex;
+		mIndexSize = dict.mIndexSize;
+		mSlotBytes = dict.mSlotBytes;
+		mBuckets = dict.mBuckets;
+		mCount = dict.mCount;
+		mUsed = dict.mUsed;
+		mCapacity = dict.mCapacity;
+		dict.initEmpty();
+	}
+
+	void destroyEntries()
+	{
+		for (S32 i = 0; i < mUsed; ++i)
+		{
+			if (mEntries[i].hash != eErasedHash)
+				mEntries[i].pair.~KVPair();
+		}
+	}
+
+	FORCE_INLINE Iterator iteratorAt(S32 position)
+	{
+		return Iterator(mEntries + position, mEntries + mUsed);
+	}
+
+	/// Hashes a key. A hash that happens to be eErasedHash is folded onto
+	/// its neighbour, which only costs a rare extra key comparison.
+	template<typename Key>
+	FORCE_INLINE size_t hashKey(const Key &key) const
+	{
+		Hash hash;
+		const size_t keyHash = hash(key);
+		return keyHash == eErasedHash ? keyHash - 1 : keyHash;
+	}
+
+	template<typename Key>
+	FORCE_INLINE S32 findEntry(const Key &key, size_t keyHash) const
+	{
+		if (mCount == 0)
+			return -1;
+
+		switch (mSlotBytes)
+		{
+		case 1: return findIn(reinterpret_cast<const U8*>(mIndex), key, keyHash);
+		case 2: return findIn(reinterpret_cast<const U16*>(mIndex), key, keyHash);
+		default: return findIn(reinterpret_cast<const U32*>(mIndex), key, keyHash);
+		}
+	}
+
+	/// Walks the probe sequence of keyHash until the key or an empty slot
+	/// turns up. The stored hash is compared before the key, so the key of
+	/// another entry is only looked at when the full hashes agree.
+	template<typename Slot, typename Key>
+	S32 findIn(const Slot *slots, const Key &key, size_t keyHash) const
+	{
+		const Slot erased = static_cast<Slot>(~static_cast<Slot>(0));
+		const size_t mask = mIndexSize - 1;
+		for (size_t i = mBuckets.bucketIndex(keyHash); ; i = (i + 1) & mask)
+		{
+			const Slot slot = slots[i];
+			if (slot == eEmptySlot)
+				return -1;
+			if (slot == erased)
+				continue;
+
+			const Entry &entry = mEntries[slot - 1];
+			if (entry.hash == keyHash && equals(entry.pair.key, key))
+				return static_cast<S32>(slot - 1);
+		}
+	}
+
+	/// Puts a position into the first free slot of the probe sequence of
+	/// keyHash. The key is known not to be within the index.
+	template<typename Slot>
+	void insertSlot(Slot *slots, size_t keyHash, S32 position)
+	{
+		const Slot erased = static_cast<Slot>(~static_cast<Slot>(0));
+		const size_t mask = mIndexSize - 1;
+		size_t i = mBuckets.bucketIndex(keyHash);
+		while (slots[i] != eEmptySlot && slots[i] != erased)
+			i = (i + 1) & mask;
+		slots[i] = static_cast<Slot>(position + 1);
+	}
+
+	/// Marks the slot that refers to position as erased. The slot is found
+	/// by its value, so no key has to be compared.
+	template<typename Slot>
+	void eraseSlot(Slot *slots, size_t keyHash, S32 position)
+	{
+		const Slot target = static_cast<Slot>(position + 1);
+		const size_t mask = mIndexSize - 1;
+		size_t i = mBuckets.bucketIndex(keyHash);
+		while (slots[i] != target)
+			i = (i + 1) & mask;
+		slots[i] = static_cast<Slot>(~static_cast<Slot>(0));
+	}
+
+	void insertIntoIndex(size_t keyHash, S32 position)
+	{
+		switch (mSlotBytes)
+		{
+		case 1: insertSlot(reinterpret_cast<U8*>(mIndex), keyHash, position); break;
+		case 2: insertSlot(reinterpret_cast<U16*>(mIndex), keyHash, position); break;
+		default: insertSlot(reinterpret_cast<U32*>(mIndex), keyHash, position); break;
+		}
+	}
+
+	template<typename K>
+	S32 appendEntry(size_t keyHash, const K &key, const DictionaryValue &value)
+	{
+		if (mUsed == mCapacity)
+			resize(mMax(static_cast<S32>(eMinCapacity), mCount * 2));
+
+		const S32 position = mUsed++;
+		Entry &entry = mEntries[position];
+		new (&entry.pair.key) DictionaryKey(key);
+		new (&entry.pair.value) DictionaryValue(value);
+		entry.hash = keyHash;
+		insertIntoIndex(keyHash, position);
+
+		++mCount;
+		return position;
+	}
+
+	/// Moves the live entries into an array of capacity entries, which
+	/// squeezes out the holes, and rebuilds the index for it.
+	void resize(S32 capacity)
+	{
+		assert(capacity >= mCount);
+
+		Entry *entries = static_cast<Entry*>(malloc(sizeof(Entry) * capacity));
+		S32 used = 0;
+		for (S32 i = 0; i < mUsed; ++i)
+		{
+			Entry &entry = mEntries[i];
+			if (entry.hash == eErasedHash)
+				continue;
+
+			new (&entries[used].pair.key) DictionaryKey(move_cast(entry.pair.key));
+			new (&entries[used].pair.value) DictionaryValue(move_cast(entry.pair.value));
+			entries[used].hash = entry.hash;
+			entry.pair.~KVPair();
+			++used;
+		}
+
+		free(mEntries);
+		mEntries = entries;
+		mUsed = used;
+		mCapacity = capacity;
+
+		// Slots have to be able to hold every position plus one, and the
+		// erased marker above that. The index is kept at most two thirds
+		// full of used entries, holes included.
+		if (static_cast<U32>(capacity) < 0xFFU)
+			mSlotBytes = 1;
+		else if (static_cast<U32>(capacity) < 0xFFFFU)
+			mSlotBytes = 2;
+		else
+			mSlotBytes = 4;
+
+		mIndexSize = FibonacciBuckets::roundBucketCount(static_cast<size_t>(capacity) + capacity / 2 + 1);
+		mIndexSize = mMax(mIndexSize, static_cast<size_t>(2));
+		mBuckets.setBucketCount(mIndexSize);
+
+		free(mIndex);
+		mIndex = calloc(mIndexSize, mSlotBytes);
+		for (S32 i = 0; i < mUsed; ++i)
+			insertIntoIndex(mEntries[i].hash, i);
+	}
+};
+
+#endif // _JBL_ORDEREDDICTIONARY_HPP_
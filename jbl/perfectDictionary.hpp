@@ -0,0 +1,569 @@
+//-----------------------------------------------------------------------------
+// perfectDictionary.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_PERFECTDICTIONARY_HPP_
+#define _JBL_PERFECTDICTIONARY_HPP_
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include "lib.hpp"
+#include "hashFunction.hpp"
+#include "vector.hpp"
+
+/// An immutable map over a key set that is known up front, such as
+/// keywords, header names or enum names.
+///
+/// build() finds a minimal perfect hash for the keys with CHD (compress,
+/// hash and displace): the keys are spread over a few small buckets, and
+/// every bucket gets a displacement that sends all of its keys to slots no
+/// other key took. There are exactly as many slots as keys, so there are
+/// no chains, no probing and no empty slots. A lookup is one key hash, a
+/// couple of multiplies and one compare against the only key that can
+/// match, and the only branch whose outcome depends on the key is that
+/// compare.
+///
+/// Besides the pairs themselves, the dictionary takes a byte per key for the
+/// displacements.
+///
+/// There is no constexpr version for literal key sets. C++11 constexpr can
+/// express the search, with recursion in place of loops the way
+/// compileTimeHash does, but it cannot change an array in place. Every
+/// placement would copy the set of taken slots, and the plain recursive
+/// form nests a call for every key and every displacement it tries. For
+/// all but small sets that runs into the constexpr depth limit of the
+/// compiler, 512 by default in GCC and Clang. Keeping the depth down takes
+/// divide and conquer recursion that costs more compile time than build()
+/// costs at startup. Small literal sets can switch on the compile time
+/// hashes of HashedKey instead, see stringHash.
+template<typename DictionaryKey, typename DictionaryValue, class Hash = HashFunction<DictionaryKey>>
+class PerfectDictionary
+{
+public:
+	/// The type that keys are looked up by. For String keys this is a
+	/// StringView, the same as for Dictionary.
+	typedef typename LookupKeyType<DictionaryKey>::Type LookupKey;
+
+	/// A key/value pair. The dictionary is built from these, and iterators
+	/// point at them.
+	struct KVPair
+	{
+		DictionaryKey key;
+		DictionaryValue value;
+	};
+
+	/// A class that is responsible for iterating over a PerfectDictionary.
+	/// The pairs are in the order of their slots, which has nothing to do
+	/// with the order they were built from.
+	/// @see CIterator
+	class Iterator
+	{
+		friend class PerfectDictionary;
+	public:
+		/// Incriments the iterator to advance it to access the next element.
+		/// @return The current iterator.
+		Iterator& operator++()
+		{
+			++mPair;
+			return *this;
+		}
+
+		bool operator==(const Iterator &it) const
+		{
+			return mPair == it.mPair;
+		}
+
+		bool operator!=(const Iterator &it) const
+		{
+			return mPair != it.mPair;
+		}
+
+		/// Dereferences the current element at the current iterator position.
+		/// @return The key/value pair at the current position.
+		KVPair& operator*() const
+		{
+			return *mPair;
+		}
+
+		KVPair* operator->() const
+		{
+			return mPair;
+		}
+
+	private:
+		KVPair *mPair;
+
+		explicit Iterator(KVPair *pair)
+		{
+			mPair = pair;
+		}
+	};
+
+	/// A class that is responsible for iterating over a PerfectDictionary.
+	/// Unlike Iterator, this version is a constant iterator.
+	/// @see Iterator
+	class CIterator
+	{
+		friend class PerfectDictionary;
+	public:
+		/// Incriments the iterator to advance it to access the next element.
+		/// @return The current iterator.
+		CIterator& operator++()
+		{
+			++mPair;
+			return *this;
+		}
+
+		bool operator==(const CIterator &it) const
+		{
+			return mPair == it.mPair;
+		}
+
+		bool operator!=(const CIterator &it) const
+		{
+			return mPair != it.mPair;
+		}
+
+		/// Dereferences the current element at the current iterator position.
+		/// @return The key/value pair at the current position.
+		const KVPair& operator*() const
+		{
+			return *mPair;
+		}
+
+		const KVPair* operator->() const
+		{
+			return mPair;
+		}
+
+	private:
+		const KVPair *mPair;
+
+		explicit CIterator(const KVPair *pair)
+		{
+			mPair = pair;
+		}
+	};
+
+	PerfectDictionary()
+	{
+		initEmpty();
+	}
+
+	PerfectDictionary(const PerfectDictionary &) = delete;
+	PerfectDictionary& operator=(const PerfectDictionary &) = delete;
+
+	PerfectDictionary(PerfectDictionary &&dict)
+	{
+		takeArrays(dict);
+	}
+
+	PerfectDictionary& operator=(PerfectDictionary &&dict)
+	{
+		if (this != &dict)
+		{
+			clear();
+			takeArrays(dict);
+		}
+		return *this;
+	}
+
+	~PerfectDictionary()
+	{
+		clear();
+	}
+
+	/// Replaces the contents of the dictionary with pairs. If a key is in
+	/// pairs more than once, the first pair wins.
+	/// @param pairs The pairs to build the dictionary from.
+	/// @param count The amount of pairs.
+	/// @return true if the dictionary was built. false if Hash gives two
+	///  different keys the same hash, as nothing can tell those apart; the
+	///  dictionary is empty afterwards.
+	bool build(const KVPair *pairs, S32 count)
+	{
+		clear();
+		if (count == 0)
+			return true;
+
+		U64 *hashes = static_cast<U64*>(malloc(sizeof(U64) * count));
+		for (S32 i = 0; i < count; ++i)
+			hashes[i] = static_cast<U64>(Hash()(pairs[i].key));
+
+		S32 *keys = static_cast<S32*>(malloc(sizeof(S32) * count));
+		const S32 keyCount = uniqueKeys(pairs, hashes, keys, count);
+
+		bool built = false;
+		if (keyCount != 0)
+		{
+			U64 seed = 0x243F6A8885A308D3ULL;
+			for (S32 attempt = 0; attempt < eMaxSeedAttempts && !built; ++attempt)
+			{
+				built = place(pairs, hashes, keys, keyCount, seed);
+				seed = finalizeHash64(seed + 0x9E3779B97F4A7C15ULL);
+			}
+		}
+
+		free(keys);
+		free(hashes);
+		return built;
+	}
+
+	/// Replaces the contents of the dictionary with pairs.
+	/// @see build(const KVPair*, S32)
+	bool build(const Vector<KVPair> &pairs)
+	{
+		return build(pairs.count() != 0 ? &pairs[0] : nullptr, pairs.count());
+	}
+
+	Iterator find(const LookupKey &key)
+	{
+		KVPair *pair = mPairs + slotOf(key);
+		return mCount != 0 && equals(pair->key, key) ? Iterator(pair) : end();
+	}
+
+	CIterator find(const LookupKey &key) const
+	{
+		const KVPair *pair = mPairs + slotOf(key);
+		return mCount != 0 && equals(pair->key, key) ? CIterator(pair) : end();
+	}
+
+	/// Checks to see if the dictionary contains key.
+	/// @param key The key to look for.
+	/// @return true if the key is within the dictionary, false otherwise.
+	bool contains(const LookupKey &key) const
+	{
+		return find(key) != end();
+	}
+
+	/// Removes every element from the dictionary and frees its memory.
+	void clear()
+	{
+		for (S32 i = 0; i < mCount; ++i)
+			mPairs[i].~KVPair();
+		free(mPairs);
+		free(mDisplacements);
+
+		mPairs = nullptr;
+		mDisplacements = nullptr;
+		mCount = 0;
+		mBucketCount = 0;
+	}
+
+	/// Gets the amount of elements within the dictionary, which is also the
+	/// amount of slots.
+	/// @return The amount of elements in the dictionary.
+	FORCE_INLINE S32 count() const
+	{
+		return mCount;
+	}
+
+	/// Gets the amount of displacement buckets.
+	/// @return The amount of buckets.
+	FORCE_INLINE S32 bucketCount() const
+	{
+		return mBucketCount;
+	}
+
+	/// Grabs an iterator at the first slot of the PerfectDictionary.
+	FORCE_INLINE Iterator begin()
+	{
+		return Iterator(mPairs);
+	}
+
+	/// Grabs an iterator at the end of the PerfectDictionary.
+	FORCE_INLINE Iterator end()
+	{
+		return Iterator(mPairs + mCount);
+	}
+
+	/// Grabs a constant iterator at the first slot of the PerfectDictionary.
+	FORCE_INLINE CIterator begin() const
+	{
+		return CIterator(mPairs);
+	}
+
+	/// Grabs a constant iterator at the end of the PerfectDictionary.
+	FORCE_INLINE CIterator end() const
+	{
+		return CIterator(mPairs + mCount);
+	}
+
+private:
+	enum Constants
+	{
+		/// The average amount of keys per bucket. Larger buckets take less
+		/// memory but are harder to place.
+		eKeysPerBucket = 4,
+
+		/// How many displacements to try per key before trying another
+		/// seed. The last buckets to be placed have to hit one of very few
+		/// free slots, which takes about as many tries as there are keys.
+		eDisplacementTriesPerKey = 16,
+
+		/// How many seeds to try before giving up. Failing with one seed
+		/// is already rare.
+		eMaxSeedAttempts = 32
+	};
+
+	KVPair *mPairs;
+	U32 *mDisplacements;
+	S32 mCount;
+	S32 mBucketCount;
+	U64 mSeed;
+
+	void initEmpty()
+	{
+		mPairs = nullptr;
+		mDisplacements = nullptr;
+		mCount = 0;
+		mBucketCount = 0;
+		mSeed = 0;
+	}
+
+	void takeArrays(PerfectDictionary &dict)
+	{
+		mPairs = dict.mPairs;
+		mDisplacements = dict.mDisplacements;
+		mCount = dict.mCount;
+		mBucketCount = dict.mBucketCount;
+		mSeed = dict.mSeed;
+		dict.initEmpty();
+	}
+
+	/// Maps the top 32 bits of hash onto [0, range) without a division.
+	static FORCE_INLINE U32 reduce(U64 hash, S32 range)
+	{
+		return static_cast<U32>(((hash >> 32) * static_cast<U64>(range)) >> 32);
+	}
+
+	FORCE_INLINE U32 bucketFor(U64 keyHash) const
+	{
+		return reduce(keyHash, mBucketCount);
+	}
+
+	/// The slot of a key with the hash keyHash when its bucket has the given
+	/// displacement. Mixing again, rather than adding the displacement to
+	/// the slot, makes every displacement an independent try.
+	FORCE_INLINE U32 slotFor(U64 keyHash, U32 displacement) const
+	{
+		return reduce(finalizeHash64(keyHash ^ (static_cast<U64>(displacement) * 0x9E3779B97F4A7C15ULL)), mCount);
+	}
+
+	FORCE_INLINE U32 slotOf(const LookupKey &key) const
+	{
+		if (mCount == 0)
+			return 0;
+
+		const U64 keyHash = finalizeHash64(static_cast<U64>(Hash()(key)) ^ mSeed);
+		return slotFor(keyHash, mDisplacements[bucketFor(keyHash)]);
+	}
+
+	/// Fills keys with the positions of the pairs whose key is not in front
+	/// of them already.
+	/// @return The amount of positions, or 0 if two different keys have the
+	///  same hash.
+	static S32 uniqueKeys(const KVPair *pairs, const U64 *hashes, S32 *keys, S32 count)
+	{
+		// Equal keys have equal hashes, so only runs of equal hashes have to
+		// be compared. The sort is stable, so the first of equal keys comes
+		// first within its run.
+		S32 *order = static_cast<S32*>(malloc(sizeof(S32) * count * 2));
+		for (S32 i = 0; i < count; ++i)
+			order[i] = i;
+		sortPositions(hashes, order, order + count, count);
+
+		S32 keyCount = 0;
+		for (S32 run = 0; run < count && keyCount >= 0; )
+		{
+			S32 runEnd = run + 1;
+			while (runEnd < count && hashes[order[runEnd]] == hashes[order[run]])
+				++runEnd;
+
+			const S32 firstKey = keyCount;
+			for (S32 i = run; i < runEnd; ++i)
+			{
+				const KVPair &pair = pairs[order[i]];
+				bool duplicate = false;
+				for (S32 j = firstKey; j < keyCount && !duplicate; ++j)
+					duplicate = equals(pairs[keys[j]].key, pair.key);
+
+				if (!duplicate)
+					keys[keyCount++] = order[i];
+			}
+
+			// Different keys within one run can never be separated.
+			if (keyCount - firstKey > 1)
+				keyCount = -1;
+			run = runEnd;
+		}
+
+		free(order);
+		return mMax(keyCount, 0);
+	}
+
+	/// Tries to find a displacement for every bucket with one seed, and
+	/// moves the pairs into their slots if it does.
+	bool place(const KVPair *pairs, const U64 *hashes, const S32 *keys, S32 keyCount, U64 seed)
+	{
+		mCount = keyCount;
+		mBucketCount = (keyCount + eKeysPerBucket - 1) / eKeysPerBucket;
+		mSeed = seed;
+
+		// Group the keys by bucket with a counting sort.
+		U64 *keyHashes = static_cast<U64*>(malloc(sizeof(U64) * keyCount));
+		S32 *bucketStart = static_cast<S32*>(calloc(mBucketCount + 1, sizeof(S32)));
+		S32 *grouped = static_cast<S32*>(malloc(sizeof(S32) * keyCount));
+		for (S32 i = 0; i < keyCount; ++i)
+		{
+			keyHashes[i] = finalizeHash64(hashes[keys[i]] ^ seed);
+			++bucketStart[bucketFor(keyHashes[i]) + 1];
+		}
+		for (S32 b = 0; b < mBucketCount; ++b)
+			bucketStart[b + 1] += bucketStart[b];
+
+		S32 *cursor = static_cast<S32*>(malloc(sizeof(S32) * mBucketCount));
+		memcpy(cursor, bucketStart, sizeof(S32) * mBucketCount);
+		for (S32 i = 0; i < keyCount; ++i)
+			grouped[cursor[bucketFor(keyHashes[i])]++] = i;
+
+		// Place the largest buckets first, while most slots are free. The
+		// buckets are ordered by a counting sort on their size.
+		S32 maxSize = 0;
+		for (S32 b = 0; b < mBucketCount; ++b)
+			maxSize = mMax(maxSize, bucketStart[b + 1] - bucketStart[b]);
+
+		S32 *sizeStart = static_cast<S32*>(calloc(maxSize + 2, sizeof(S32)));
+		S32 *buckets = cursor;
+		for (S32 b = 0; b < mBucketCount; ++b)
+			++sizeStart[maxSize - (bucketStart[b + 1] - bucketStart[b]) + 1];
+		for (S32 s = 0; s <= maxSize; ++s)
+			sizeStart[s + 1] += sizeStart[s];
+		for (S32 b = 0; b < mBucketCount; ++b)
+			buckets[sizeStart[maxSize - (bucketStart[b + 1] - bucketStart[b])]++] = b;
+		free(sizeStart);
+
+		mDisplacements = static_cast<U32*>(calloc(mBucketCount, sizeof(U32)));
+		const U64 maxDisplacement = mMin(static_cast<U64>(keyCount) * eDisplacementTriesPerKey + 1024, static_cast<U64>(0xFFFFFFFF));
+		U64 *taken = static_cast<U64*>(calloc((keyCount + 63) / 64, sizeof(U64)));
+		U32 *slots = static_cast<U32*>(malloc(sizeof(U32) * keyCount));
+
+		bool placed = true;
+		for (S32 i = 0; i < mBucketCount && placed; ++i)
+		{
+			const S32 b = buckets[i];
+			const S32 first = bucketStart[b];
+			const S32 last = bucketStart[b + 1];
+			if (first == last)
+				break;
+
+			placed = false;
+			for (U64 displacement = 0; displacement <= maxDisplacement && !placed; ++displacement)
+			{
+				// Take slots until one is taken already, then give them back.
+				S32 k = first;
+				for (; k < last; ++k)
+				{
+					const U32 slot = slotFor(keyHashes[grouped[k]], static_cast<U32>(displacement));
+					const U64 bit = static_cast<U64>(1) << (slot & 63);
+					if (taken[slot >> 6] & bit)
+						break;
+					taken[slot >> 6] |= bit;
+					slots[grouped[k]] = slot;
+				}
+
+				placed = k == last;
+				if (placed)
+					mDisplacements[b] = static_cast<U32>(displacement);
+				else
+				{
+					for (S32 undo = first; undo < k; ++undo)
+						taken[slots[grouped[undo]] >> 6] &= ~(static_cast<U64>(1) << (slots[grouped[undo]] & 63));
+				}
+			}
+		}
+
+		if (placed)
+		{
+			mPairs = static_cast<KVPair*>(malloc(sizeof(KVPair) * keyCount));
+			for (S32 i = 0; i < keyCount; ++i)
+				new (&mPairs[slots[i]]) KVPair(pairs[keys[i]]);
+		}
+		else
+		{
+			free(mDisplacements);
+			mDisplacements = nullptr;
+			mCount = 0;
+			mBucketCount = 0;
+		}
+
+		free(slots);
+		free(taken);
+		free(cursor);
+		free(grouped);
+		free(bucketStart);
+		free(keyHashes);
+		return placed;
+	}
+
+	/// Stable bottom up merge sort of positions by hash.
+	static void sortPositions(const U64 *hashes, S32 *order, S32 *scratch, S32 count)
+	{
+		S32 *from = order;
+		S32 *to = scratch;
+		for (S32 width = 1; width < count; width *= 2)
+		{
+			for (S32 start = 0; start < count; start += width * 2)
+			{
+				const S32 middle = mMin(start + width, count);
+				const S32 stop = mMin(start + width * 2, count);
+
+				S32 left = start;
+				S32 right = middle;
+				S32 out = start;
+				while (left < middle && right < stop)
+				{
+					if (hashes[from[right]] < hashes[from[left]])
+						to[out++] = from[right++];
+					else
+						to[out++] = from[left++];
+				}
+				while (left < middle)
+					to[out++] = from[left++];
+				while (right < stop)
+					to[out++] = from[right++];
+			}
+
+			S32 *swap = from;
+			from = to;
+			to = swap;
+		}
+
+		if (from != order)
+			memcpy(order, from, sizeof(S32) * count);
+	}
+};
+
+#endif // _JBL_PERFECTDICTIONARY_HPP_
@@ -0,0 +1,353 @@
+//-----------------------------------------------------------------------------
+// readMostlyDictionary.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_READMOSTLYDICTIONARY_HPP_
+#define _JBL_READMOSTLYDICTIONARY_HPP_
+
+#include <stdio.h>
+#include <new>
+#include "lib.hpp"
+#include "atomic.hpp"
+#include "mutex.hpp"
+#include "dictionary.hpp"
+
+/// A Dictionary for tables that are read from many threads all the time and
+/// written to rarely, such as configuration or routing tables.
+///
+/// Readers never take a lock and never write to memory that another thread
+/// touches. Every version of the table is immutable once it is published.
+/// A writer copies the current version, changes the copy and swaps the
+/// pointer to it, so a write costs O(n). Use update() to apply many changes
+/// with a single copy.
+///
+/// Old versions are reclaimed with epochs. Every Reader owns a slot on its
+/// own cache line, and announces the global epoch in it for as long as it
+/// is looking at a version. A retired version is only deleted once every
+/// slot is either idle or announces a later epoch than the version was
+/// retired in, as such readers can only have seen a newer version.
+template<typename DictionaryKey, typename DictionaryValue, class Hash = HashFunction<DictionaryKey>>
+class ReadMostlyDictionary
+{
+public:
+	typedef Dictionary<DictionaryKey, DictionaryValue, Hash> Table;
+	typedef typename Table::LookupKey LookupKey;
+
+private:
+	enum Constants
+	{
+		eDefaultMaxReaders = 64
+	};
+
+	struct alignas(CACHE_LINE_SIZE) ReaderSlot
+	{
+		/// The epoch the reader entered in, or 0 while it is not reading.
+		Atomic<U64> epoch;
+		Atomic<U32> inUse;
+	};
+
+	struct Version
+	{
+		Table table;
+		U64 retireEpoch;
+		Version *nextRetired;
+	};
+
+public:
+	/// The read side of a ReadMostlyDictionary. Every thread that reads has
+	/// to use its own Reader, and it has to be destroyed before the
+	/// dictionary is.
+	class Reader
+	{
+	public:
+		/// Claims a reader slot of the dictionary.
+		/// @param dictionary The dictionary to read from. It must have a
+		///  free slot, see the maxReaders parameter of its constructor. The
+		///  process is aborted if it does not.
+		explicit Reader(ReadMostlyDictionary *dictionary)
+		{
+			mDictionary = dictionary;
+			mSlot = dictionary->claimSlot();
+		}
+
+		~Reader()
+		{
+			mSlot->inUse.store(0, eMemoryOrderRelease);
+		}
+
+		Reader(const Reader &) = delete;
+		Reader& operator=(const Reader &) = delete;
+
+		/// Looks up a key and copies its value out.
+		/// @param key The key to look for.
+		/// @param value Filled with a copy of the value if the key was found.
+		/// @return true if the key was found, false otherwise.
+		bool find(const LookupKey &key, DictionaryValue &value)
+		{
+			const Table &table = enter();
+			auto position = table.find(key);
+			const bool found = position != table.end();
+			if (found)
+				value = position->value;
+			exit();
+			return found;
+		}
+
+		/// Checks to see if the dictionary contains key.
+		/// @param key The key to look for.
+		/// @return true if the key is within the dictionary, false otherwise.
+		bool contains(const LookupKey &key)
+		{
+			const bool found = enter().contains(key);
+			exit();
+			return found;
+		}
+
+		/// Calls fn with the current version of the table. The version
+		/// stays alive until fn returns, so many lookups can be done against
+		/// one consistent version for the cost of one.
+		/// @param fn Called as fn(const Table &). It must not keep references
+		///  into the table after it returns, and must not write to the
+		///  dictionary.
+		template<typename Function>
+		void read(Function fn)
+		{
+			fn(enter());
+			exit();
+		}
+
+	private:
+		ReadMostlyDictionary *mDictionary;
+		ReaderSlot *mSlot;
+
+		const Table& enter()
+		{
+			// The epoch has to be visible to writers before the version is
+			// loaded, which the sequentially consistent store and load give.
+			// A reader that sees an epoch also sees every version that was
+			// published before that epoch began.
+			mSlot->epoch.store(mDictionary->mEpoch.load(eMemoryOrderAcquire));
+			return mDictionary->mCurrent.load()->table;
+		}
+
+		void exit()
+		{
+			mSlot->epoch.store(0, eMemoryOrderRelease);
+		}
+	};
+
+	/// Creates a ReadMostlyDictionary.
+	/// @param maxReaders The amount of Readers that can exist at once.
+	explicit ReadMostlyDictionary(S32 maxReaders = eDefaultMaxReaders)
+	{
+		mSlotCount = mMax(maxReaders, 1);
+		mSlots = static_cast<ReaderSlot*>(alignedMalloc(sizeof(ReaderSlot) * mSlotCount, CACHE_LINE_SIZE));
+		for (S32 i = 0; i < mSlotCount; ++i)
+			new (&mSlots[i]) ReaderSlot();
+
+		mEpoch.store(1);
+		mCurrent.store(new Version());
+		mRetired = nullptr;
+	}
+
+	ReadMostlyDictionary(const ReadMostlyDictionary &) = delete;
+	ReadMostlyDictionary& operator=(const ReadMostlyDictionary &) = delete;
+
+	/// Destroys the dictionary. No Reader may exist anymore.
+	~ReadMostlyDictionary()
+	{
+		delete mCurrent.load();
+		while (mRetired != nullptr)
+		{
+			Version *next = mRetired->nextRetired;
+			delete mRetired;
+			mRetired = next;
+		}
+
+		for (S32 i = 0; i < mSlotCount; ++i)
+			mSlots[i].~ReaderSlot();
+		alignedFree(mSlots);
+	}
+
+	/// Inserts a key/value pair if the key is not within the dictionary yet.
+	/// Nothing is copied if the key is already there.
+	/// @return true if the pair was inserted, false if the key was already
+	///  there.
+	bool insert(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		LockGuard guard(&mWriteMutex);
+		if (mCurrent.load()->table.contains(key))
+			return false;
+
+		Version *version = copyCurrent();
+		version->table.insert(key, value);
+		publish(version);
+		return true;
+	}
+
+	/// Inserts a key/value pair, or assigns value to the existing element if
+	/// the key is already within the dictionary.
+	/// @return true if the pair was inserted, false if it was assigned.
+	bool insertOrAssign(const DictionaryKey &key, const DictionaryValue &value)
+	{
+		LockGuard guard(&mWriteMutex);
+		Version *version = copyCurrent();
+		const bool inserted = version->table.insertOrAssign(key, value).inserted;
+		publish(version);
+		return inserted;
+	}
+
+	/// Erases the element with the key. Nothing is copied if the key is not
+	/// within the dictionary.
+	/// @return true if an element was erased, false if the key was not found.
+	bool erase(const LookupKey &key)
+	{
+		LockGuard guard(&mWriteMutex);
+		if (!mCurrent.load()->table.contains(key))
+			return false;
+
+		Version *version = copyCurrent();
+		version->table.erase(version->table.find(key));
+		publish(version);
+		return true;
+	}
+
+	/// Applies many changes at once. fn gets a private copy of the current
+	/// version, which readers start to see once fn returns.
+	/// @param fn Called as fn(Table &).
+	template<typename Function>
+	void update(Function fn)
+	{
+		LockGuard guard(&mWriteMutex);
+		Version *version = copyCurrent();
+		fn(version->table);
+		publish(version);
+	}
+
+	/// Gets the amount of elements within the current version.
+	/// @return The amount of elements in the dictionary.
+	S32 count() const
+	{
+		LockGuard guard(&mWriteMutex);
+		return mCurrent.load()->table.count();
+	}
+
+	/// Deletes every retired version that no reader can be looking at
+	/// anymore. Writes do this by themselves, this is only needed to let go
+	/// of memory when there are no more writes coming.
+	void reclaim()
+	{
+		LockGuard guard(&mWriteMutex);
+		reclaimRetired();
+	}
+
+	/// Gets the amount of old versions that are waiting on readers.
+	/// @return The amount of retired versions.
+	S32 retiredCount() const
+	{
+		LockGuard guard(&mWriteMutex);
+		S32 retired = 0;
+		for (Version *version = mRetired; version != nullptr; version = version->nextRetired)
+			++retired;
+		return retired;
+	}
+
+private:
+	Atomic<Version*> mCurrent;
+	Atomic<U64> mEpoch;
+
+	ReaderSlot *mSlots;
+	S32 mSlotCount;
+
+	/// Guards the writers and the retired list. Readers never touch it.
+	mutable Mutex mWriteMutex;
+	Version *mRetired;
+
+	ReaderSlot* claimSlot()
+	{
+		for (S32 i = 0; i < mSlotCount; ++i)
+		{
+			U32 expected = 0;
+			if (mSlots[i].inUse.compareExchange(expected, 1))
+				return &mSlots[i];
+		}
+
+		// A Reader without a slot cannot protect the versions it reads, so
+		// stop right here instead of failing later in a less obvious place.
+		fprintf(stderr, "ReadMostlyDictionary is out of reader slots. Raise maxReaders.\n");
+		abort();
+	}
+
+	Version* copyCurrent() const
+	{
+		const Table &current = mCurrent.load()->table;
+
+		Version *version = new Version();
+		version->table.reserve(current.count() + 1);
+		for (auto &pair : current)
+			version->table.insert(pair.key, pair.value);
+		return version;
+	}
+
+	/// Makes version the current version and retires the previous one.
+	void publish(Version *version)
+	{
+		Version *previous = mCurrent.exchange(version);
+
+		// Readers that see the new epoch entered after the swap.
+		previous->retireEpoch = mEpoch.fetchAdd(1);
+		previous->nextRetired = mRetired;
+		mRetired = previous;
+
+		reclaimRetired();
+	}
+
+	void reclaimRetired()
+	{
+		// Find the oldest epoch that a reader is still in.
+		U64 oldestReader = ~static_cast<U64>(0);
+		for (S32 i = 0; i < mSlotCount; ++i)
+		{
+			const U64 epoch = mSlots[i].epoch.load();
+			if (epoch != 0)
+				oldestReader = mMin(oldestReader, epoch);
+		}
+
+		Version **link = &mRetired;
+		while (*link != nullptr)
+		{
+			Version *version = *link;
+			if (version->retireEpoch < oldestReader)
+			{
+				*link = version->nextRetired;
+				delete version;
+			}
+			else
+			{
+				link = &version->nextRetired;
+			}
+		}
+	}
+};
+
+#endif // _JBL_READMOSTLYDICTIONARY_HPP_
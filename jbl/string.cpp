@@ -1,5 +1,5 @@
 //-----------------------------------------------------------------------------
-// thread.cpp
+// string.cpp
 //
 // Copyright (c) 2016-2017 Jeff Hutchinson
 //
@@ -32,44 +32,62 @@ String::String()
 	memset(mStackBuffer, 0, sizeof(char) * Constants::eSSO);
 	mHeapBuffer = nullptr;
 	mCount = 0;
-	mCapacity = Constants::eSSO;
+	mCapacity = Constants::eSSOContents;
 }
 
-String::String(const char *str)
+String::String(const char *str) :
+	String(str, static_cast<S32>(strlen(str)))
 {
+}
+
+String::String(const StringView &view) :
+	String(view.data(), view.length())
+{
+}
+
+String::String(const char *str, S32 length)
+{
+	// Zeroing the stack buffer also marks the hash of a heap string as not
+	// cached yet.
 	memset(mStackBuffer, 0, sizeof(char) * Constants::eSSO);
-	mCount = strlen(str);
-	if (mCount < Constants::eSSO)
+	mCount = length;
+	if (mCount <= Constants::eSSOContents)
 	{
 		memcpy(mStackBuffer, str, sizeof(char) * mCount);
-		mCapacity = Constants::eSSO;
+		mCapacity = Constants::eSSOContents;
 		mHeapBuffer = nullptr;
 	}
 	else
 	{
 		mCapacity = mCount;
-		mHeapBuffer = reinterpret_cast<char*>(calloc(mCount + 1, sizeof(char)));
+		mHeapBuffer = reinterpret_cast<char*>(malloc((mCount + 1) * sizeof(char)));
 		memcpy(mHeapBuffer, str, mCount * sizeof(char));
 		mHeapBuffer[mCount] = 0x0; // Null terminator
 	}
 }
 
 String::String(const String &str) :
-	String(str.c_str())
+	String(str.c_str(), str.mCount)
 {
+	// The copy holds the same characters, so it can keep the hash of them.
+	if (mHeapBuffer != nullptr && str.mHeapBuffer != nullptr)
+		mHashCache = str.mHashCache;
 }
 
 String::String(String &&str)
 {
 	// I can't move assign two stack buffers. So I have to memcpy this.
-	// Luckilly, the heap buffer can be moved.
+	// Luckilly, the heap buffer can be moved, and the cached hash comes
+	// along with the stack buffer.
 	memcpy(mStackBuffer, str.mStackBuffer, Constants::eSSO);
 	mHeapBuffer = str.mHeapBuffer;
 	mCapacity = str.mCapacity;
 	mCount = str.mCount;
 	
+	// Leave the moved from string empty.
+	memset(str.mStackBuffer, 0, sizeof(char) * Constants::eSSO);
 	str.mHeapBuffer = nullptr;
-	str.mCapacity = 0;
+	str.mCapacity = Constants::eSSOContents;
 	str.mCount = 0;
 }
 
@@ -84,25 +102,11 @@ String::~String()
 
 String& String::operator=(const String &str)
 {
-	if (mHeapBuffer != nullptr)
-		delete[] mHeapBuffer;
-	
-	mCount = str.mCount;
-	if (mCount < Constants::eSSO - 1)
-	{
-		memcpy(mStackBuffer, str.mStackBuffer, sizeof(char) * mCount);
-		mCapacity = Constants::eSSO;
-		mHeapBuffer = nullptr;
-	}
-	else
-	{
-		mCapacity = str.mCapacity;
-		mHeapBuffer = reinterpret_cast<char*>(calloc(mCount + 1, sizeof(char)));
-		memcpy(mHeapBuffer, str.mHeapBuffer, mCount * sizeof(char));
-		mHeapBuffer[mCount] = 0x0; // Null terminator
-	}
-	
-	return *this;
+	if (this == &str)
+		return *this;
+
+	String copy(str);
+	return *this = move_cast(copy);
 }
 
 String& String::operator=(String &&str)
@@ -110,17 +114,20 @@ String& String::operator=(String &&str)
 	if (this != &str)
 	{
 		if (mHeapBuffer != nullptr)
-			delete[] mHeapBuffer;
+			free(mHeapBuffer);
 		
 		// I can't move assign two stack buffers. So I have to memcpy this.
-		// Luckilly, the heap buffer can be moved.
+		// Luckilly, the heap buffer can be moved, and the cached hash comes
+		// along with the stack buffer.
 		memcpy(mStackBuffer, str.mStackBuffer, Constants::eSSO);
 		mHeapBuffer = str.mHeapBuffer;
 		mCapacity = str.mCapacity;
 		mCount = str.mCount;
 		
+		// Leave the moved from string empty.
+		memset(str.mStackBuffer, 0, sizeof(char) * Constants::eSSO);
 		str.mHeapBuffer = nullptr;
-		str.mCapacity = 0;
+		str.mCapacity = Constants::eSSOContents;
 		str.mCount = 0;
 	}
 	return *this;
@@ -129,67 +136,39 @@ String& String::operator=(String &&str)
 String String::operator+(const String &str)
 {
 	String ret;
-	ret.mCount = ret.mCapacity = str.mCount + mCount;
-	if (ret.mCount >= Constants::eSSOContents)
+	const S32 count = mCount + str.mCount;
+	if (count > Constants::eSSOContents)
 	{
 		// Doesn't fit in buffer. Alloc
-		ret.mHeapBuffer = reinterpret_cast<char*>(calloc(ret.mCount + 1, sizeof(char)));
-		memcpy(ret.mHeapBuffer, mHeapBuffer, mCount * sizeof(char));
-		memcpy(ret.mHeapBuffer + mCount, str.mHeapBuffer, str.mCount * sizeof(char));
-	}
-	else
-	{
-		// Fits in small string buffer.
-		memcpy(ret.mStackBuffer, mStackBuffer, mCount * sizeof(char));
-		memcpy(ret.mStackBuffer + mCount, str.mStackBuffer, str.mCount * sizeof(char));
+		ret.growHeap(count);
 	}
+
+	char *buffer = (ret.mHeapBuffer != nullptr) ? ret.mHeapBuffer : ret.mStackBuffer;
+	memcpy(buffer, c_str(), mCount * sizeof(char));
+	memcpy(buffer + mCount, str.c_str(), str.mCount * sizeof(char));
+	buffer[count] = 0x0; // Null terminator
+	ret.mCount = count;
 	return ret;
 }
 
 String& String::operator+=(const String &str)
 {
-	S32 count = mCount + str.mCount;
-	if (count >= Constants::eSSO)
-	{
-		if (mHeapBuffer != nullptr)
-		{
-			// It must have been reserved then, since its empty.
-			if (mHeapBuffer[0] == 0x0)
-			{
-				// We need to copy into the heap buffer from the stack.
-				memcpy(mHeapBuffer, mStackBuffer, Constants::eSSOContents * sizeof(char));
-			}
-			
-			if ((count + 1) < mCapacity)
-			{
-				memcpy(mHeapBuffer + mCount, str.c_str(), str.mCount * sizeof(char));
-				mCount = count;
-				mHeapBuffer[count] = 0x0; // Null terminator
-			}
-			else
-			{
-				// Realloc
-				mCapacity = static_cast<S32>(mCapacity * 1.5f);
-				mHeapBuffer = reinterpret_cast<char*>(realloc(mHeapBuffer, mCapacity * sizeof(char)));
-				memcpy(mHeapBuffer + mCount, str.c_str(), str.mCount * sizeof(char));
-				mCount = count;
-				mHeapBuffer[count] = 0x0; // Null terminator
-			}
-		}
-		else
-		{
-			mHeapBuffer = reinterpret_cast<char*>(calloc(count + 1, sizeof(char)));
-			memcpy(mHeapBuffer, mStackBuffer, Constants::eSSOContents * sizeof(char));
-			memcpy(mHeapBuffer + mCount, str.c_str(), str.mCount * sizeof(char));
-			mCount = count;
-			mCapacity = mCount;
-		}
-	}
-	else
+	const S32 count = mCount + str.mCount;
+	if (count > mCapacity)
 	{
-		memcpy(mStackBuffer + mCount, str.mStackBuffer, sizeof(char) * str.mCount);
-		mCount += str.mCount;
+		// Grow by half again, so that appending one character at a time
+		// does not realloc every time.
+		growHeap(mMax(count, mCapacity + mCapacity / 2));
 	}
+
+	// Fetch the characters to append after growing, as str might be this.
+	char *buffer = (mHeapBuffer != nullptr) ? mHeapBuffer : mStackBuffer;
+	memcpy(buffer + mCount, str.c_str(), str.mCount * sizeof(char));
+	buffer[count] = 0x0; // Null terminator
+	mCount = count;
+
+	if (mHeapBuffer != nullptr)
+		mHashCache.valid = false;
 	return *this;
 }
 
@@ -200,9 +179,7 @@ char String::operator[](S32 index)
 		assert(false);
 #endif
 	
-	if (mCount < Constants::eSSOContents)
-		return mStackBuffer[index];
-	return mHeapBuffer[index];
+	return c_str()[index];
 }
 
 const char String::operator[](S32 index) const
@@ -212,19 +189,30 @@ const char String::operator[](S32 index) const
 		assert(false);
 #endif
 	
-	if (mCount < Constants::eSSOContents)
-		return mStackBuffer[index];
-	return mHeapBuffer[index];
+	return c_str()[index];
 }
 
-const char* String::c_str() const
+void String::reserve(S32 size)
 {
-	return (mCount < Constants::eSSO) ? mStackBuffer : mHeapBuffer;
+	if (size > mCapacity)
+		growHeap(size);
 }
 
-void String::reserve(S32 size)
+void String::growHeap(S32 capacity)
 {
-	mHeapBuffer = reinterpret_cast<char*>(realloc(mHeapBuffer, size * sizeof(char)));
-	mHeapBuffer[mCount] = 0x0; // Null termination
-	mCapacity = size;
+	if (mHeapBuffer == nullptr)
+	{
+		// Copy the null terminator along with the characters.
+		char *buffer = reinterpret_cast<char*>(malloc((capacity + 1) * sizeof(char)));
+		memcpy(buffer, mStackBuffer, (mCount + 1) * sizeof(char));
+		mHeapBuffer = buffer;
+	}
+	else
+	{
+		mHeapBuffer = reinterpret_cast<char*>(realloc(mHeapBuffer, (capacity + 1) * sizeof(char)));
+	}
+	mCapacity = capacity;
+
+	// The stack buffer of a small string held its characters, not a hash.
+	mHashCache.valid = false;
 }
@@ -26,12 +26,19 @@
 #define _JBL_STRING_H_
 
 #include "lib.hpp"
+#include "hash.hpp"
+
+class StringView;
 
 /// Note: This implementation of small string optimization needs massive
 /// improvements to get the most out of SSO.
 ///
 /// Also, the implementation of this code is branch heavy. This needs
 /// to be addressed eventually.
+///
+/// The characters live in the heap buffer once there is one, and in the
+/// stack buffer otherwise. A heap string leaves the stack buffer unused, so
+/// it can keep the hash of its characters there.
 
 class String
 {
@@ -47,6 +54,8 @@ class String
 public:
 	String();
 	String(const char *str);
+	String(const char *str, S32 length);
+	explicit String(const StringView &view);
 	String(const String &str);
 	String(String &&str);
 	~String();
@@ -62,17 +71,116 @@ public:
 	
 	FORCE_INLINE S32 length() const { return mCount; };
 	
-	const char* c_str() const;
+	FORCE_INLINE const char* c_str() const
+	{
+		return (mHeapBuffer != nullptr) ? mHeapBuffer : mStackBuffer;
+	}
 	
 	void reserve(S32 size);
+
+	/// Gets the hash of the characters, the same as stringHash of a view of
+	/// them. This reads the hash that a heap string has cached and hashes
+	/// the characters otherwise. It never writes the cache, so any amount of
+	/// threads can hash the same String at once.
+	/// @return The hash of the characters, without the seed of the process.
+	FORCE_INLINE U64 textHash() const
+	{
+		if (mHeapBuffer != nullptr && mHashCache.valid)
+			return mHashCache.hash;
+		return hashBytes(c_str(), static_cast<size_t>(mCount));
+	}
+
+	/// Gets the hash of the characters like the const version, and caches it
+	/// for a heap string until the string is changed. Later calls, const ones
+	/// included, then never hash the characters again. A small string is not
+	/// cached, as hashing it is as cheap as reading a cache.
+	/// @return The hash of the characters, without the seed of the process.
+	FORCE_INLINE U64 textHash()
+	{
+		if (mHeapBuffer == nullptr)
+			return hashBytes(mStackBuffer, static_cast<size_t>(mCount));
+
+		if (!mHashCache.valid)
+		{
+			mHashCache.hash = hashBytes(mHeapBuffer, static_cast<size_t>(mCount));
+			mHashCache.valid = true;
+		}
+		return mHashCache.hash;
+	}
 	
 private:
-	char mStackBuffer[Constants::eSSO];
+	struct HashCache
+	{
+		U64 hash;
+		bool valid;
+	};
+
+	/// Moves the characters into a heap buffer that fits capacity characters
+	/// and a null terminator.
+	void growHeap(S32 capacity);
+
+	union
+	{
+		char mStackBuffer[Constants::eSSO];
+		HashCache mHashCache;
+	};
 	char *mHeapBuffer;
 	S32 mCount;
-	S32 mCapacity;
+	S32 mCapacity; // Characters that fit, not counting the null terminator.
+
+	static_assert(sizeof(HashCache) <= Constants::eSSO, "The hash cache has to fit in the stack buffer.");
 };
 
+/// A view of a run of characters that is owned by someone else, such as a
+/// String, a string literal, or a buffer that was read from the network.
+/// Views are cheap to create and copy, but the memory that they point to has
+/// to outlive them. The characters are not required to be null terminated.
+class StringView
+{
+public:
+	FORCE_INLINE StringView() : mData(""), mLength(0) {}
+	FORCE_INLINE StringView(const char *str) : mData(str), mLength(static_cast<S32>(strlen(str))) {}
+	FORCE_INLINE StringView(const char *str, S32 length) : mData(str), mLength(length) {}
+	FORCE_INLINE StringView(const String &str) : mData(str.c_str()), mLength(str.length()) {}
+
+	FORCE_INLINE const char* data() const { return mData; }
+	FORCE_INLINE S32 length() const { return mLength; }
+
+private:
+	const char *mData;
+	S32 mLength;
+};
+
+inline bool operator==(const StringView &lhs, const StringView &rhs)
+{
+	// Shortcut, if the lengths don't match it's obviously not equal.
+	if (lhs.length() != rhs.length())
+		return false;
+	return memcmp(lhs.data(), rhs.data(), static_cast<size_t>(lhs.length())) == 0;
+}
+
+inline bool operator==(const String &lhs, const StringView &rhs)
+{
+	return StringView(lhs) == rhs;
+}
+
+inline bool operator==(const StringView &lhs, const String &rhs)
+{
+	return lhs == StringView(rhs);
+}
+
+// Equals overrides so that String keys can be compared against a view
+// without constructing a String.
+FORCE_INLINE bool equals(const String &lhs, const StringView &rhs)
+{
+	return lhs == rhs;
+}
+
+FORCE_INLINE bool equals(const StringView &lhs, const String &rhs)
+{
+	return lhs == rhs;
+}
+
 inline bool operator==(const String &lhs, const String &rhs)
 {
 	// Shortcut, if the lengths don't match it's obviously not equal.
@@ -91,4 +199,30 @@ inline bool operator==(const String &lhs, const String &rhs)
 	return true;
 }
 
+// Orders strings by their bytes, and shorter strings before longer strings
+// that they are the start of.
+inline bool operator<(const StringView &lhs, const StringView &rhs)
+{
+	const S32 length = mMin(lhs.length(), rhs.length());
+	const S32 result = memcmp(lhs.data(), rhs.data(), static_cast<size_t>(length));
+	if (result != 0)
+		return result < 0;
+	return lhs.length() < rhs.length();
+}
+
+inline bool operator<(const String &lhs, const StringView &rhs)
+{
+	return StringView(lhs) < rhs;
+}
+
+inline bool operator<(const StringView &lhs, const String &rhs)
+{
+	return lhs < StringView(rhs);
+}
+
+inline bool operator<(const String &lhs, const String &rhs)
+{
+	return StringView(lhs) < StringView(rhs);
+}
+
 #endif // _JBL_STRING_H_
@@ -24,6 +24,7 @@
 
 #include <stdlib.h>
 #include "thread.hpp"
+#include "threadTasks.hpp"
 
 #ifndef _WIN32
 #include <unistd.h>
@@ -99,3 +100,19 @@ void Thread::join()
 #endif
 	mDone = true;
 }
+
+void runOnThreads(void *tasks, size_t taskSize, S32 taskCount, void (*fn)(void*))
+{
+	char *first = static_cast<char*>(tasks);
+	Thread **threads = new Thread*[taskCount];
+	for (S32 i = 0; i < taskCount - 1; ++i)
+		threads[i] = new Thread(fn, first + taskSize * i);
+	fn(first + taskSize * (taskCount - 1));
+
+	for (S32 i = 0; i < taskCount - 1; ++i)
+	{
+		threads[i]->join();
+		delete threads[i];
+	}
+	delete[] threads;
+}
@@ -0,0 +1,42 @@
+//-----------------------------------------------------------------------------
+// threadTasks.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_THREADTASKS_H_
+#define _JBL_THREADTASKS_H_
+
+#include <stddef.h>
+#include "types.hpp"
+
+/// Runs fn with every task, on a thread each. The last task runs on the
+/// calling thread, and this returns once every task is done.
+///
+/// This only declares what thread.cpp defines, so that headers can spread
+/// work over threads without pulling in the platform thread headers.
+/// @param tasks The first of taskCount tasks that lie next to each other.
+/// @param taskSize The size of a task in bytes.
+/// @param taskCount The amount of tasks. Has to be at least 1.
+/// @param fn Called with a pointer to its task.
+void runOnThreads(void *tasks, size_t taskSize, S32 taskCount, void (*fn)(void*));
+
+#endif // _JBL_THREADTASKS_H_
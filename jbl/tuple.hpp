@@ -0,0 +1,122 @@
+//-----------------------------------------------------------------------------
+// tuple.hpp
+//
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#ifndef _JBL_TUPLE_HPP_
+#define _JBL_TUPLE_HPP_
+
+#include "lib.hpp"
+#include "hashFunction.hpp"
+
+/// Two values that are used together, most of all as a composite key of a
+/// Dictionary. Pairs compare equal if both of their values do, and have a
+/// HashFunction that combines the hashes of both values in order.
+template<typename First, typename Second>
+struct Pair
+{
+	First first;
+	Second second;
+
+	Pair() : first(), second() {}
+
+	Pair(const First &pairFirst, const Second &pairSecond) :
+		first(pairFirst),
+		second(pairSecond)
+	{
+	}
+
+	bool operator==(const Pair &other) const
+	{
+		return first == other.first && second == other.second;
+	}
+
+	bool operator!=(const Pair &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+/// Three values that are used together, such as a (tenant, shard, id) key.
+/// @see Pair
+template<typename First, typename Second, typename Third>
+struct Triple
+{
+	First first;
+	Second second;
+	Third third;
+
+	Triple() : first(), second(), third() {}
+
+	Triple(const First &tripleFirst, const Second &tripleSecond, const Third &tripleThird) :
+		first(tripleFirst),
+		second(tripleSecond),
+		third(tripleThird)
+	{
+	}
+
+	bool operator==(const Triple &other) const
+	{
+		return first == other.first && second == other.second && third == other.third;
+	}
+
+	bool operator!=(const Triple &other) const
+	{
+		return !(*this == other);
+	}
+};
+
+/// Makes a Pair, deducing the types from the arguments.
+template<typename First, typename Second>
+FORCE_INLINE Pair<First, Second> makePair(const First &first, const Second &second)
+{
+	return Pair<First, Second>(first, second);
+}
+
+/// Makes a Triple, deducing the types from the arguments.
+template<typename First, typename Second, typename Third>
+FORCE_INLINE Triple<First, Second, Third> makeTriple(const First &first, const Second &second, const Third &third)
+{
+	return Triple<First, Second, Third>(first, second, third);
+}
+
+template<typename First, typename Second>
+class HashFunction<Pair<First, Second>>
+{
+public:
+	FORCE_INLINE size_t operator()(const Pair<First, Second> &ref) const
+	{
+		return hashValues(ref.first, ref.second);
+	}
+};
+
+template<typename First, typename Second, typename Third>
+class HashFunction<Triple<First, Second, Third>>
+{
+public:
+	FORCE_INLINE size_t operator()(const Triple<First, Second, Third> &ref) const
+	{
+		return hashValues(ref.first, ref.second, ref.third);
+	}
+};
+
+#endif // _JBL_TUPLE_HPP_
@@ -49,5 +49,37 @@ namespace TypeTraits
 	template<typename A>
 	struct IsSame<A, A> : IntegralConstant<bool, true> {};
 	/// @endgroup IsSame
+
+	/// @group IsTriviallyDestructible
+	///
+	/// Checks if type T has a destructor that does nothing, so that it does
+	/// not have to be called. Has a value of true if it does nothing, false
+	/// otherwise.
+	template<typename T>
+	struct IsTriviallyDestructible : IntegralConstant<bool, __has_trivial_destructor(T)> {};
+	/// @endgroup IsTriviallyDestructible
+
+	/// @group IsTriviallyCopyable
+	///
+	/// Checks if type T can be copied with memcpy. Has a value of true if it
+	/// can, false otherwise.
+	template<typename T>
+	struct IsTriviallyCopyable : IntegralConstant<bool, __is_trivially_copyable(T)> {};
+	/// @endgroup IsTriviallyCopyable
+
+	/// @group EnableIf
+	///
+	/// Has a member type of T if condition is true, and no member type
+	/// otherwise. It takes an overload out of the set when its condition
+	/// does not hold.
+	template<bool condition, typename T = void>
+	struct EnableIf {};
+
+	template<typename T>
+	struct EnableIf<true, T>
+	{
+		typedef T type;
+	};
+	/// @endgroup EnableIf
 };
 #endif // _JBL_TYPETRAITS_HPP_
\ No newline at end of file
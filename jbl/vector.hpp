@@ -275,7 +275,7 @@ public:
 	 * @param index The location of the element.
 	 * @return The element at the specified index.
 	 */
-	inline T operator[](S32 index) const
+	inline const T& operator[](S32 index) const
 	{
 		assert(index >= 0 && index < mCount);
 		return mArray[index];
@@ -0,0 +1,139 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include <stdio.h>
+#include "jbl/lib.hpp"
+#include "jbl/string.hpp"
+#include "jbl/cache.hpp"
+
+static S32 sLastEvicted;
+
+void rememberEviction(const S32 &key, S32 &value, void *userData)
+{
+	sLastEvicted = key;
+	++*static_cast<S32*>(userData);
+}
+
+void countStringEviction(const String &key, String &value, void *userData)
+{
+	++*static_cast<S32*>(userData);
+}
+
+template<class Cache>
+S32 churn(Cache &cache)
+{
+	// Keys are picked from twice the capacity, with a hot set that is hit
+	// all the time, and the cache has to stay consistent throughout.
+	S32 failures = 0;
+	U32 random = 12345;
+	for (S32 i = 0; i < 100000; ++i)
+	{
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+
+		const S32 key = (i & 1) ? static_cast<S32>(random % 16) : static_cast<S32>(random % 512);
+		const S32 *value = cache.find(key);
+		if (value != nullptr && *value != key * 2)
+			++failures;
+		if (value == nullptr)
+			cache.insertOrAssign(key, key * 2);
+		if ((i % 1000) == 999)
+			cache.erase(key);
+	}
+
+	if (cache.count() > cache.capacity())
+		++failures;
+	cache.clear();
+	if (cache.count() != 0 || cache.contains(1))
+		++failures;
+	return failures;
+}
+
+S32 main(S32 argc, const char **argv)
+{
+	S32 failures = 0;
+
+	S32 evictions = 0;
+	LruCache<S32, S32> lru(3);
+	lru.setEvictionCallback(rememberEviction, &evictions);
+	lru.insertOrAssign(1, 10);
+	lru.insertOrAssign(2, 20);
+	lru.insertOrAssign(3, 30);
+	lru.find(1);
+	lru.insertOrAssign(4, 40);
+	printf("LRU evicted %d. The expected result was 2.\n", sLastEvicted);
+	if (sLastEvicted != 2 || lru.contains(2) || !lru.contains(1))
+		++failures;
+
+	// peek does not count as a use, so 3 is still the least recent.
+	lru.peek(3);
+	lru.insertOrAssign(5, 50);
+	if (sLastEvicted != 3 || evictions != 2 || lru.count() != 3)
+		++failures;
+
+	// Erasing does not call the callback.
+	lru.erase(1);
+	if (evictions != 2 || lru.count() != 2 || *lru.find(4) != 40)
+		++failures;
+
+	// SIEVE passes over the visited 1 and evicts 2, then evicts 3 without
+	// moving the hand back to the tail.
+	SieveCache<S32, S32> sieve(3);
+	sieve.setEvictionCallback(rememberEviction, &evictions);
+	sieve.insertOrAssign(1, 10);
+	sieve.insertOrAssign(2, 20);
+	sieve.insertOrAssign(3, 30);
+	sieve.find(1);
+	sieve.insertOrAssign(4, 40);
+	const S32 firstEvicted = sLastEvicted;
+	sieve.insertOrAssign(5, 50);
+	printf("SIEVE evicted %d then %d. The expected result was 2 then 3.\n", firstEvicted, sLastEvicted);
+	if (firstEvicted != 2 || sLastEvicted != 3 || !sieve.contains(1))
+		++failures;
+
+	S32 stringEvictions = 0;
+	LruCache<String, String> strings(2);
+	strings.setEvictionCallback(countStringEviction, &stringEvictions);
+	strings.insertOrAssign("this string is long enough to avoid the SSO engine", "so is this string, it lives on the heap too");
+	strings.insertOrAssign("short", "value");
+	strings.insertOrAssign("another key", "another value");
+	if (stringEvictions != 1 || strings.contains("this string is long enough to avoid the SSO engine") || !strings.contains(StringView("short")))
+		++failures;
+
+	lru.setEvictionCallback(nullptr);
+	sieve.setEvictionCallback(nullptr);
+	LruCache<S32, S32> lruChurn(64);
+	SieveCache<S32, S32> sieveChurn(64);
+	const S32 churnFailures = churn(lruChurn) + churn(sieveChurn);
+	printf("Churn failures: %d. The expected result was 0.\n", churnFailures);
+	failures += churnFailures;
+
+	if (failures != 0)
+		printf("There were %d failures. This is a failure!\n", failures);
+
+#ifdef _WIN32
+   system("pause");
+#endif
+	return failures == 0 ? 0 : 1;
+}
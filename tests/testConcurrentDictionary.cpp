@@ -0,0 +1,112 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include "jbl/types.hpp"
+#include "jbl/thread.hpp"
+#include "jbl/concurrentDictionary.hpp"
+
+static const S32 sThreadCount = 8;
+static const S32 sKeysPerThread = 10000;
+
+ConcurrentDictionary<S32, S32> kv;
+Mutex failureMutex;
+S32 failures = 0;
+
+void worker(void *arg)
+{
+	const S32 first = *static_cast<S32*>(arg) * sKeysPerThread;
+	S32 localFailures = 0;
+
+	for (S32 i = first; i < first + sKeysPerThread; ++i)
+	{
+		if (!kv.insert(i, i * 2))
+			++localFailures;
+	}
+
+	for (S32 i = first; i < first + sKeysPerThread; ++i)
+	{
+		S32 value;
+		if (!kv.find(i, value) || value != i * 2)
+			++localFailures;
+	}
+
+	// Erase every odd key again.
+	for (S32 i = first + 1; i < first + sKeysPerThread; i += 2)
+	{
+		if (!kv.erase(i))
+			++localFailures;
+	}
+
+	LockGuard guard(&failureMutex);
+	failures += localFailures;
+}
+
+S32 main(S32 argc, const char **argv)
+{
+	S32 ids[sThreadCount];
+	Thread *threads[sThreadCount];
+	for (S32 i = 0; i < sThreadCount; ++i)
+	{
+		ids[i] = i;
+		threads[i] = new Thread(worker, &ids[i]);
+	}
+	for (S32 i = 0; i < sThreadCount; ++i)
+	{
+		threads[i]->join();
+		delete threads[i];
+	}
+
+	printf("kv has %d elements in %d shards. The expected result was %d.\n", kv.count(), kv.shardCount(), sThreadCount * sKeysPerThread / 2);
+	if (kv.count() != sThreadCount * sKeysPerThread / 2)
+		++failures;
+
+	S32 visited = 0;
+	kv.forEach([&](const ConcurrentDictionary<S32, S32>::KVPair &pair) {
+		if ((pair.key & 1) || pair.value != pair.key * 2)
+			++failures;
+		++visited;
+	});
+	printf("forEach visited %d elements. The expected result was %d.\n", visited, sThreadCount * sKeysPerThread / 2);
+
+	S32 value;
+	if (kv.find(1, value) || !kv.contains(2))
+		++failures;
+
+	kv.insertOrAssign(2, 5);
+	kv.find(2, value);
+	printf("After insertOrAssign 2 is %d. The expected result was 5.\n", value);
+
+	ConcurrentDictionary<String, String> kvStrings(4);
+	kvStrings.insert("hello", "world");
+	String greeting;
+	kvStrings.find("hello", greeting);
+	printf("kvStrings hello is %s. The expected result was world.\n", greeting.c_str());
+
+	if (failures != 0)
+		printf("There were %d failures. This is a failure!\n", failures);
+
+#ifdef _WIN32
+   system("pause");
+#endif
+	return failures == 0 ? 0 : 1;
+}
@@ -25,6 +25,17 @@
 #include "jbl/vector.hpp"
 #include "jbl/dictionary.hpp"
 
+static S32 sHashCalls = 0;
+
+struct CountingHash
+{
+	size_t operator()(S32 key)
+	{
+		++sHashCalls;
+		return static_cast<size_t>(key);
+	}
+};
+
 S32 main(S32 argc, const char **argv)
 {
 	Dictionary<String, S32> kv(32);
@@ -55,10 +66,52 @@ S32 main(S32 argc, const char **argv)
 		printf(" kv: %s, %d\n", kvPair.key.c_str(), kvPair.value);
 	}
 
+	// Inserting a key that is already there must not add a second element.
+	auto duplicate = kv.insert("hello", 100);
+	printf("Inserting hello again %s, its value is %d. The expected result was not inserted, 2.\n", duplicate.inserted ? "inserted" : "did not insert", (*duplicate.iterator).value);
+
+	auto assigned = kv.insertOrAssign("hello", 3);
+	printf("insertOrAssign hello %s, its value is %d. The expected result was not inserted, 3.\n", assigned.inserted ? "inserted" : "did not insert", kv["hello"]);
+
+	String movedKey = "a key that is long enough to be moved off the heap";
+	kv.insert(move_cast(movedKey), 7);
+	kv.tryEmplace("emplaced", 8);
+	kv.tryEmplace("emplaced", 9);
+	printf("kv has %d elements, emplaced is %d. The expected result was 4, 8.\n", kv.count(), kv["emplaced"]);
+
+	Dictionary<S32, String> kvStrings;
+	kvStrings.tryEmplace(1, "built in place");
+	kvStrings.insertOrAssign(1, String("assigned to a string that lives on the heap"));
+	printf("kvStrings[1] is %s. The expected result was assigned to a string that lives on the heap.\n", kvStrings[1].c_str());
+
+	// Iterators hand out the stored pairs, so writes go into the dictionary.
+	for (auto &kvPair : kvStrings)
+		kvPair.value = "written through an iterator";
+	const Dictionary<S32, String> &constStrings = kvStrings;
+	auto constPosition = constStrings.find(1);
+	printf("kvStrings[1] is %s, 2 is %s. The expected result was written through an iterator, missing.\n",
+		constPosition != constStrings.end() ? constPosition->value.c_str() : "missing",
+		constStrings.find(2) != constStrings.end() ? "found" : "missing");
+
+	// Look up by a view into a buffer without building a String.
+	const char buffer[] = "hello world pq";
+	StringView helloView(buffer, 5);
+	StringView worldView(buffer + 6, 5);
+	printf("Lookup by view: hello %s, world %s. The expected result was found, missing.\n",
+		kv.contains(helloView) ? "found" : "missing",
+		kv.contains(worldView) ? "found" : "missing");
+	kv[StringView(buffer + 12, 2)] = 67;
+	printf(" kv: %s, %d. The expected result was 67.\n", "pq", kv["pq"]);
+
 	Dictionary<S32, S32> kvInts(5);
 	for (S32 i = 0; i < 1000; ++i)
 		kvInts.insert(i, i);
 
+	// The table started with 5 buckets, it should have grown by itself.
+	printf("kvInts has %d elements in %d buckets. The load factor is %.2f.\n", kvInts.count(), kvInts.bucketCount(), kvInts.loadFactor());
+	if (kvInts.loadFactor() > kvInts.maxLoadFactor())
+		printf("The load factor is above the maximum load factor. This is a failure!\n");
+
 	// Print out the 1-1000
 	printf("kvInts Dictionary Contents:\n");
 	for (S32 i = 0; i < 1000; i++)
@@ -77,6 +130,215 @@ S32 main(S32 argc, const char **argv)
 	}
 	printf("%s. The expected result was no.\n", no ? "no" : "yes.");
 
+	kvInts.shrinkToFit();
+	printf("After shrinkToFit kvInts has %d buckets. The expected result was 2.\n", kvInts.bucketCount());
+	kvInts.reserve(64);
+	printf("After reserve(64) kvInts has %d buckets. The expected result was 64.\n", kvInts.bucketCount());
+
+	// Grow a dictionary incrementally and make sure everything can be found
+	// and iterated over while the old table is still being emptied.
+	Dictionary<S32, S32> kvIncremental(4);
+	kvIncremental.setIncrementalRehash(true, 1);
+	S32 incrementalFailures = 0;
+	bool sawRehash = false;
+	for (S32 i = 0; i < 5000; ++i)
+	{
+		const S32 oldBuckets = kvIncremental.bucketCount();
+		kvIncremental.insert(i, i * 3);
+		if (kvIncremental.isRehashing())
+		{
+			sawRehash = true;
+
+			// Both tables are allocated while the old one is being emptied,
+			// each with its occupancy bitmap.
+			if (kvIncremental.bucketCount() != oldBuckets)
+			{
+				const size_t expectedBytes = Dictionary<S32, S32>::tableBytes(kvIncremental.bucketCount()) + Dictionary<S32, S32>::tableBytes(oldBuckets);
+				if (kvIncremental.stats().tableBytes != expectedBytes)
+					++incrementalFailures;
+			}
+
+			S32 seen = 0;
+			for (const auto &vals : kvIncremental)
+			{
+				if (vals.value != vals.key * 3)
+					++incrementalFailures;
+				++seen;
+			}
+			if (seen != kvIncremental.count())
+				++incrementalFailures;
+		}
+	}
+	for (S32 i = 0; i < 5000; ++i)
+	{
+		if (!(kvIncremental.find(i) != kvIncremental.end()) || kvIncremental[i] != i * 3)
+			++incrementalFailures;
+	}
+	for (S32 i = 0; i < 5000; i += 2)
+		kvIncremental.erase(kvIncremental.find(i));
+	if (kvIncremental.count() != 2500)
+		++incrementalFailures;
+	printf("Incremental rehash %s, failures: %d. The expected result was 0.\n", sawRehash ? "happened" : "did not happen", incrementalFailures);
+
+	// Modulo bucket selection keeps any bucket count.
+	Dictionary<S32, S32, HashFunction<S32>, ModuloBuckets> kvModulo(7);
+	S32 moduloFailures = 0;
+	for (S32 i = 0; i < 600; i += 6)
+		kvModulo.insert(i, i);
+	for (S32 i = 0; i < 600; ++i)
+	{
+		if (kvModulo.contains(i) != (i % 6 == 0))
+			++moduloFailures;
+	}
+	printf("kvModulo has %d elements in %d buckets, failures: %d. The expected result was 100, 112, 0.\n", kvModulo.count(), kvModulo.bucketCount(), moduloFailures);
+
+	// Growing reuses the hashes stored in the cells, every key is hashed once.
+	Dictionary<S32, S32, CountingHash> kvCounted(2);
+	for (S32 i = 0; i < 1000; ++i)
+		kvCounted.insert(i, i);
+	printf("Inserting 1000 keys hashed %d times. The expected result was 1000.\n", sHashCalls);
+
+	// Insert and look up keys in batches, half of the second batch is
+	// already within the dictionary. The lookups run while the incremental
+	// rehash is still moving buckets.
+	Dictionary<S32, S32> kvBatch(4);
+	kvBatch.setIncrementalRehash(true, 1);
+	S32 batchKeys[4000];
+	S32 batchValues[4000];
+	S32 *batchFound[4000];
+	for (S32 i = 0; i < 4000; ++i)
+	{
+		batchKeys[i] = i;
+		batchValues[i] = i * 5;
+	}
+	S32 batchInserted = kvBatch.insertBatch(batchKeys, batchValues, 2000);
+	batchInserted += kvBatch.insertBatch(batchKeys + 1000, batchValues + 1000, 2000);
+	S32 batchHits = kvBatch.findBatch(batchKeys, 4000, batchFound);
+	S32 batchFailures = kvBatch.isRehashing() ? 0 : 1;
+	for (S32 i = 0; i < 4000; ++i)
+	{
+		if (i < 3000 ? (batchFound[i] == nullptr || *batchFound[i] != i * 5) : batchFound[i] != nullptr)
+			++batchFailures;
+	}
+	printf("Batches inserted %d and found %d, failures: %d. The expected result was 3000, 3000, 0.\n", batchInserted, batchHits, batchFailures);
+
+	// Build in parallel from pairs with duplicates, the first of them wins.
+	Vector<Dictionary<S32, S32>::KVPair> parallelPairs;
+	for (S32 i = 0; i < 100000; ++i)
+		parallelPairs.add(Dictionary<S32, S32>::KVPair(i % 60000, i));
+	Dictionary<S32, S32> kvParallel;
+	kvParallel.insert(-1, -1);
+	kvParallel.buildParallel(parallelPairs, 4);
+	S32 parallelFailures = kvParallel.contains(-1) ? 1 : 0;
+	for (S32 i = 0; i < 60000; ++i)
+	{
+		auto position = kvParallel.find(i);
+		if (position == kvParallel.end() || position->value != i)
+			++parallelFailures;
+	}
+	for (S32 i = 0; i < 60000; i += 2)
+		kvParallel.erase(kvParallel.find(i));
+	kvParallel.insert(60000, 60000);
+	printf("kvParallel has %d elements, failures: %d. The expected result was 30001, 0.\n", kvParallel.count(), parallelFailures);
+
+	// The histogram has to account for every bucket and every element.
+	Dictionary<S32, S32> kvStats;
+	for (S32 i = 0; i < 500; ++i)
+		kvStats.insert(i, i);
+	for (S32 i = 0; i < 500; i += 5)
+		kvStats.erase(kvStats.find(i));
+	DictionaryStats stats = kvStats.stats();
+	S32 histogramBuckets = 0;
+	S32 histogramElements = 0;
+	for (S32 i = 0; i < DictionaryStats::eChainHistogramSize; ++i)
+	{
+		histogramBuckets += stats.chainHistogram[i];
+		histogramElements += stats.chainHistogram[i] * i;
+	}
+	dumpDictionaryStats(stats);
+	S32 statsFailures = 0;
+	if (stats.count != 400 || histogramBuckets != stats.bucketCount || stats.usedBuckets != stats.bucketCount - stats.chainHistogram[0])
+		++statsFailures;
+	if (stats.maxChainLength < DictionaryStats::eChainHistogramSize - 1 && histogramElements != stats.count)
+		++statsFailures;
+	if (stats.averageProbeLength < 1.0f || stats.chainedCells + stats.usedBuckets != stats.count || stats.poolPages != kvStats.poolPageCount())
+		++statsFailures;
+	if (stats.tableBytes != Dictionary<S32, S32>::tableBytes(kvStats.bucketCount()))
+		++statsFailures;
+	printf("kvStats has %d elements, stats failures: %d. The expected result was 400, 0.\n", stats.count, statsFailures);
+
+	// A dictionary that was moved from can still be cleared and used again.
+	Dictionary<S32, S32> kvMoved(move_cast(kvStats));
+	kvStats.clear();
+	kvStats.insert(1, 2);
+	printf("After a move kvMoved has %d elements and kvStats has %d. The expected result was 400 and 1.\n", kvMoved.count(), kvStats.count());
+
+	// A table sized for far more elements than it holds. Iteration skips the
+	// empty buckets through the occupancy bitmap.
+	Dictionary<S32, S32> kvSparse(1 << 16);
+	S32 sparseFailures = 0;
+	for (S32 i = 0; i < 64; ++i)
+		kvSparse.insert(i * 7919, i);
+	for (auto it = kvSparse.begin(); it != kvSparse.end(); )
+	{
+		if ((it->value & 1) != 0)
+			it = kvSparse.erase(it);
+		else
+			++it;
+	}
+	S32 sparseSeen = 0;
+	for (const auto &pair : kvSparse)
+	{
+		if ((pair.value & 1) != 0 || pair.key != pair.value * 7919)
+			++sparseFailures;
+		++sparseSeen;
+	}
+	kvSparse.clear();
+	if (kvSparse.begin() != kvSparse.end() || kvSparse.bucketCount() != 1 << 16)
+		++sparseFailures;
+	printf("kvSparse iterated %d elements, failures: %d. The expected result was 32, 0.\n", sparseSeen, sparseFailures);
+
+	// Keys hashed at compile time find the same elements as plain lookups.
+	Dictionary<String, S32> kvHashed;
+	kvHashed["content-length"] = 10;
+	kvHashed["content-type"] = 20;
+	constexpr HashedKey contentLength("content-length");
+	S32 hashedFailures = 0;
+	if (kvHashed.find(contentLength) == kvHashed.end() || kvHashed.find(contentLength)->value != 10)
+		++hashedFailures;
+	if (!kvHashed.contains("content-type"_hashed) || kvHashed.contains("host"_hashed))
+		++hashedFailures;
+	kvHashed["host"_hashed] = 30;
+	if (kvHashed["host"] != 30 || kvHashed.count() != 3)
+		++hashedFailures;
+	printf("kvHashed has %d elements, failures: %d. The expected result was 3, 0.\n", kvHashed.count(), hashedFailures);
+
+	// Constantly insert and erase long strings. Erased cells are recycled,
+	// so the amount of pool pages has to stay flat after the first round.
+	Dictionary<String, String> churn(64);
+	churn.setMaxLoadFactor(4.0f);
+	S32 firstRoundPages = 0;
+	for (S32 round = 0; round < 100; ++round)
+	{
+		for (S32 i = 0; i < 256; ++i)
+		{
+			char key[64];
+			snprintf(key, sizeof(key), "this is a long churn key that lives on the heap %d", i);
+			churn.insert(key, key);
+		}
+		auto churnIter = churn.begin();
+		while (churnIter != churn.end())
+			churnIter = churn.erase(churnIter);
+
+		if (round == 0)
+			firstRoundPages = churn.poolPageCount();
+	}
+	printf("Churn used %d pool pages after the first round and %d after the last round. The expected result was equal.\n", firstRoundPages, churn.poolPageCount());
+
+	churn.insert("this string is long enough to avoid the SSO engine", "so is this string, it lives on the heap too");
+	churn.clear();
+	printf("After clear churn has %d elements and %d pool pages. The expected result was 0 and %d.\n", churn.count(), churn.poolPageCount(), firstRoundPages);
+
 	constexpr S32 inc = 6;
 	printf("Now lets add some items and remove a few of them.\n");
 	for (S32 i = 100; i < 200; i += inc)
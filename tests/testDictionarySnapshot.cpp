@@ -0,0 +1,102 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include <stdio.h>
+#include "jbl/lib.hpp"
+#include "jbl/string.hpp"
+#include "jbl/dictionary.hpp"
+#include "jbl/dictionarySnapshot.hpp"
+
+struct Route
+{
+	S32 port;
+	F32 weight;
+};
+
+static const char *sPath = "testDictionarySnapshot.bin";
+
+S32 main(S32 argc, const char **argv)
+{
+	S32 failures = 0;
+
+	Dictionary<String, Route> routes;
+	for (S32 i = 0; i < 1000; ++i)
+	{
+		char key[64];
+		snprintf(key, sizeof(key), "tenant-%d.example.com/route", i);
+		Route route;
+		route.port = 8000 + i;
+		route.weight = static_cast<F32>(i) * 0.5f;
+		routes.insert(key, route);
+	}
+	routes.insert("", Route());
+
+	if (!DictionarySnapshot<Route>::write(routes, sPath))
+	{
+		printf("Could not write %s. This is a failure!\n", sPath);
+		return 1;
+	}
+
+	DictionarySnapshot<Route> snapshot;
+	SnapshotResult result = snapshot.open(sPath);
+	printf("Opening the snapshot gave %d with %d elements. The expected result was %d with 1001 elements.\n", result, snapshot.count(), eSnapshotOk);
+	if (result != eSnapshotOk || snapshot.count() != routes.count())
+		++failures;
+
+	for (auto &pair : routes)
+	{
+		const Route *route = snapshot.find(pair.key);
+		if (route == nullptr || route->port != pair.value.port || route->weight != pair.value.weight)
+			++failures;
+	}
+	if (snapshot.contains("tenant-1000.example.com/route") || snapshot.contains("tenant-1.example.com"))
+		++failures;
+
+	// Mapping with the wrong value type must not work.
+	DictionarySnapshot<S32> wrongType;
+	if (wrongType.open(sPath) != eSnapshotBadValueType || wrongType.contains("tenant-1.example.com/route"))
+		++failures;
+	snapshot.close();
+
+	// Flip a byte within the strings and the checksum has to catch it.
+	FILE *file = fopen(sPath, "r+b");
+	fseek(file, -5, SEEK_END);
+	fputc('?', file);
+	fclose(file);
+	result = snapshot.open(sPath);
+	printf("Opening the damaged snapshot gave %d. The expected result was %d.\n", result, eSnapshotBadChecksum);
+	if (result != eSnapshotBadChecksum || snapshot.isOpen())
+		++failures;
+
+	remove(sPath);
+	if (snapshot.open(sPath) != eSnapshotFileError)
+		++failures;
+
+	if (failures != 0)
+		printf("There were %d failures. This is a failure!\n", failures);
+
+#ifdef _WIN32
+   system("pause");
+#endif
+	return failures == 0 ? 0 : 1;
+}
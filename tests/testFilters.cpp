@@ -0,0 +1,203 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include <stdio.h>
+#include "jbl/lib.hpp"
+#include "jbl/string.hpp"
+#include "jbl/bloomFilter.hpp"
+#include "jbl/cuckooFilter.hpp"
+#include "jbl/filteredDictionary.hpp"
+
+static const S32 sKeyCount = 20000;
+
+void makeKey(char *buffer, size_t size, S32 i)
+{
+	snprintf(buffer, size, "tenant-%d.example.com/route", i);
+}
+
+/// Leaves the mixing to the filter, so that the test can tell where a key
+/// lands without the seed of the process.
+struct UnseededHash
+{
+	size_t operator()(S32 key) const
+	{
+		return static_cast<size_t>(key);
+	}
+};
+
+/// Checks if both buckets of a key are among the first two of a CuckooFilter
+/// with bucketCount buckets. This mirrors CuckooFilter::locate.
+bool isCrowded(S32 key, U32 bucketCount)
+{
+	const U64 mixed = finalizeHash64(static_cast<U64>(key));
+	U16 fingerprint = static_cast<U16>(mixed >> 48);
+	fingerprint += static_cast<U16>(fingerprint == 0);
+	const U32 bucket = static_cast<U32>(mixed) & (bucketCount - 1);
+	const U32 other = (bucket ^ (static_cast<U32>(fingerprint) * 0x5BD1E995U)) & (bucketCount - 1);
+	return bucket < 2 && other < 2;
+}
+
+S32 main(S32 argc, const char **argv)
+{
+	S32 failures = 0;
+	char key[64];
+
+	// Even keys go in, odd keys never do.
+	BloomFilter<String> bloom(sKeyCount, 0.01f);
+	for (S32 i = 0; i < sKeyCount; ++i)
+	{
+		makeKey(key, sizeof(key), i * 2);
+		bloom.insert(key);
+	}
+
+	S32 bloomFalsePositives = 0;
+	for (S32 i = 0; i < sKeyCount; ++i)
+	{
+		makeKey(key, sizeof(key), i * 2);
+		if (!bloom.mayContain(key))
+			++failures;
+		makeKey(key, sizeof(key), i * 2 + 1);
+		if (bloom.mayContain(key))
+			++bloomFalsePositives;
+	}
+	const F32 bloomRate = static_cast<F32>(bloomFalsePositives) / sKeyCount;
+	printf("BloomFilter of %u bytes has a false positive rate of %.4f. The expected result was at most 0.0100.\n",
+		static_cast<U32>(bloom.byteSize()), bloomRate);
+	if (bloomRate > 0.01f)
+		++failures;
+
+	CuckooFilter<S32> cuckoo(sKeyCount);
+	for (S32 i = 0; i < sKeyCount; ++i)
+	{
+		if (!cuckoo.insert(i * 2))
+			++failures;
+	}
+
+	S32 cuckooFalsePositives = 0;
+	for (S32 i = 0; i < sKeyCount; ++i)
+	{
+		if (!cuckoo.mayContain(i * 2))
+			++failures;
+		if (cuckoo.mayContain(i * 2 + 1))
+			++cuckooFalsePositives;
+	}
+	printf("CuckooFilter of %u bytes holds %d keys with %d false positives. The expected result was %d keys with only a few.\n",
+		static_cast<U32>(cuckoo.byteSize()), cuckoo.count(), cuckooFalsePositives, sKeyCount);
+	if (cuckoo.count() != sKeyCount || cuckooFalsePositives > sKeyCount / 1000)
+		++failures;
+
+	// Erase every other key, the rest must stay.
+	for (S32 i = 0; i < sKeyCount; i += 2)
+	{
+		if (!cuckoo.erase(i * 2))
+			++failures;
+	}
+	S32 erasedStillThere = 0;
+	for (S32 i = 0; i < sKeyCount; ++i)
+	{
+		const bool there = cuckoo.mayContain(i * 2);
+		if ((i & 1) != 0 && !there)
+			++failures;
+		if ((i & 1) == 0 && there)
+			++erasedStillThere;
+	}
+	if (cuckoo.count() != sKeyCount / 2 || erasedStillThere > sKeyCount / 1000)
+		++failures;
+
+	// Overfill a small filter. It has to say so, and must not lose keys.
+	CuckooFilter<S32> small(64);
+	S32 added = 0;
+	while (small.insert(added))
+		++added;
+	S32 lost = 0;
+	for (S32 i = 0; i < added; ++i)
+	{
+		if (!small.mayContain(i))
+			++lost;
+	}
+	printf("A CuckooFilter sized for 64 keys took %d keys and lost %d. The expected result was at least 64 and 0.\n", added, lost);
+	if (added < 64 || lost != 0 || !small.isFull())
+		++failures;
+
+	// Grow a filtered dictionary far past its expected size.
+	FilteredDictionary<String, S32> filtered(16);
+	for (S32 i = 0; i < sKeyCount; ++i)
+	{
+		makeKey(key, sizeof(key), i * 2);
+		filtered.insert(key, i);
+	}
+	for (S32 i = 0; i < sKeyCount; i += 3)
+	{
+		makeKey(key, sizeof(key), i * 2);
+		filtered.erase(key);
+	}
+
+	S32 filteredFailures = 0;
+	for (S32 i = 0; i < sKeyCount; ++i)
+	{
+		makeKey(key, sizeof(key), i * 2);
+		auto position = filtered.find(key);
+		const bool expected = (i % 3) != 0;
+		if ((position != filtered.end()) != expected || (expected && position->value != i))
+			++filteredFailures;
+
+		makeKey(key, sizeof(key), i * 2 + 1);
+		if (filtered.contains(key))
+			++filteredFailures;
+	}
+	printf("FilteredDictionary has %d elements, failures: %d. The expected result was %d, 0.\n",
+		filtered.count(), filteredFailures, sKeyCount - (sKeyCount + 2) / 3);
+	failures += filteredFailures;
+
+	// Ten keys that all share two buckets of a filter of 32 buckets. Two
+	// buckets hold eight keys and the victim slot one more, so the rebuild
+	// that sizes the filter to 32 buckets runs out of room and has to be
+	// retried larger. No key may be left out of the filter.
+	FilteredDictionary<S32, S32, UnseededHash> crowded(16);
+	S32 crowdedKeys[10];
+	S32 crowdedCount = 0;
+	for (S32 i = 0; crowdedCount < 10; ++i)
+	{
+		if (isCrowded(i, 32))
+			crowdedKeys[crowdedCount++] = i;
+	}
+	for (S32 i = 0; i < crowdedCount; ++i)
+		crowded.insert(crowdedKeys[i], i);
+
+	S32 crowdedFailures = 0;
+	for (S32 i = 0; i < crowdedCount; ++i)
+	{
+		if (!crowded.contains(crowdedKeys[i]))
+			++crowdedFailures;
+	}
+	printf("Crowded FilteredDictionary failures: %d. The expected result was 0.\n", crowdedFailures);
+	failures += crowdedFailures;
+
+	if (failures != 0)
+		printf("There were %d failures. This is a failure!\n", failures);
+
+#ifdef _WIN32
+   system("pause");
+#endif
+	return failures == 0 ? 0 : 1;
+}
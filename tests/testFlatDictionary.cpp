@@ -0,0 +1,95 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include "jbl/lib.hpp"
+#include "jbl/string.hpp"
+#include "jbl/flatDictionary.hpp"
+
+S32 main(S32 argc, const char **argv)
+{
+	S32 failures = 0;
+
+	FlatDictionary<String, S32> kv;
+	kv.insert("world", 4);
+	kv.insert("hello", 2);
+	kv["pq"] = 66;
+	if (kv.insert("hello", 100).inserted)
+		++failures;
+
+	printf("First dictionary contents, in key order:\n");
+	for (auto kvPair : kv)
+		printf(" kv: %s, %d\n", kvPair.key.c_str(), kvPair.value);
+
+	const char buffer[] = "hello world";
+	printf("Lookup by view: hello %s, hell %s. The expected result was found, missing.\n",
+		kv.contains(StringView(buffer, 5)) ? "found" : "missing",
+		kv.contains(StringView(buffer, 4)) ? "found" : "missing");
+
+	kv.erase(kv.find("pq"));
+	kv.insertOrAssign("hello", 3);
+	printf("kv has %d elements, hello is %d. The expected result was 2, 3.\n", kv.count(), kv["hello"]);
+
+	// Build from unsorted pairs with duplicates, the first of them wins.
+	Vector<FlatDictionary<S32, S32>::KVPair> pairs;
+	for (S32 i = 0; i < 1000; ++i)
+	{
+		FlatDictionary<S32, S32>::KVPair pair;
+		pair.key = (i * 7919) % 500;
+		pair.value = i;
+		pairs.add(pair);
+	}
+
+	FlatDictionary<S32, S32> kvInts;
+	kvInts.build(pairs);
+	printf("kvInts has %d elements. The expected result was 500.\n", kvInts.count());
+
+	S32 previous = -1;
+	for (auto kvPair : kvInts)
+	{
+		if (kvPair.key <= previous)
+			++failures;
+		previous = kvPair.key;
+	}
+
+	for (S32 i = 0; i < 500; ++i)
+	{
+		// Every key shows up once within the first 500 pairs.
+		auto position = kvInts.find(i);
+		if (position == kvInts.end() || (*position).value >= 500 || (*position).key != i)
+			++failures;
+	}
+	if (kvInts.contains(-1) || kvInts.contains(500))
+		++failures;
+
+	const FlatDictionary<S32, S32> &constInts = kvInts;
+	if (constInts.find(250) == constInts.end())
+		++failures;
+
+	if (failures != 0)
+		printf("There were %d failures. This is a failure!\n", failures);
+
+#ifdef _WIN32
+   system("pause");
+#endif
+	return failures == 0 ? 0 : 1;
+}
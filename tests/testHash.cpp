@@ -0,0 +1,400 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+// Quality checks for hashBytes in the spirit of SMHasher: avalanche, the
+// spread of sequential keys over buckets, collisions, and sensitivity to the
+// length and the seed. Also checks the HashFunctions of integers, floats and
+// composite keys.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "jbl/lib.hpp"
+#include "jbl/hash.hpp"
+#include "jbl/hashFunction.hpp"
+#include "jbl/tuple.hpp"
+#include "jbl/dictionary.hpp"
+
+static U64 sRandomState = 0x9E3779B97F4A7C15ULL;
+
+static U64 nextRandom()
+{
+	// splitmix64, only used to make up test keys.
+	U64 z = (sRandomState += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+static int compareU64(const void *lhs, const void *rhs)
+{
+	const U64 a = *static_cast<const U64*>(lhs);
+	const U64 b = *static_cast<const U64*>(rhs);
+	return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+/// Flips every input bit of random keys and checks that every output bit
+/// flips with a probability close to one half.
+static S32 testAvalanche(size_t length)
+{
+	const S32 samples = 1000;
+	const S32 inputBits = static_cast<S32>(length * 8);
+	S32 *flips = static_cast<S32*>(calloc(inputBits * 64, sizeof(S32)));
+	U8 key[64];
+
+	for (S32 sample = 0; sample < samples; ++sample)
+	{
+		for (size_t i = 0; i < length; ++i)
+			key[i] = static_cast<U8>(nextRandom());
+		const U64 hash = hashBytes(key, length);
+
+		for (S32 bit = 0; bit < inputBits; ++bit)
+		{
+			key[bit / 8] ^= static_cast<U8>(1 << (bit % 8));
+			const U64 diff = hash ^ hashBytes(key, length);
+			key[bit / 8] ^= static_cast<U8>(1 << (bit % 8));
+
+			for (S32 out = 0; out < 64; ++out)
+				flips[bit * 64 + out] += static_cast<S32>((diff >> out) & 1);
+		}
+	}
+
+	// With 1000 samples the standard deviation is about 0.016, so anything
+	// outside of 0.4 to 0.6 is a real bias.
+	F64 worst = 0.0;
+	for (S32 i = 0; i < inputBits * 64; ++i)
+	{
+		const F64 bias = static_cast<F64>(flips[i]) / samples - 0.5;
+		worst = mMax(worst, bias < 0.0 ? -bias : bias);
+	}
+	free(flips);
+
+	printf("Avalanche of %2d byte keys is off by at most %.3f. The expected result was below 0.100.\n", static_cast<S32>(length), worst);
+	return worst < 0.1 ? 0 : 1;
+}
+
+/// Puts sequential keys into 1024 buckets by the low and by the high bits of
+/// their hashes, and checks that no bucket gets far more than its share.
+static S32 testDistribution(const char *name, bool asText)
+{
+	const S32 keyCount = 1 << 18;
+	const S32 bucketCount = 1024;
+	S32 low[bucketCount];
+	S32 high[bucketCount];
+	memset(low, 0, sizeof(low));
+	memset(high, 0, sizeof(high));
+
+	for (S32 i = 0; i < keyCount; ++i)
+	{
+		U64 hash;
+		if (asText)
+		{
+			char key[32];
+			const S32 length = snprintf(key, sizeof(key), "key%d", i);
+			hash = hashBytes(key, static_cast<size_t>(length));
+		}
+		else
+		{
+			const U64 key = static_cast<U64>(i);
+			hash = hashBytes(&key, sizeof(key));
+		}
+		++low[hash & (bucketCount - 1)];
+		++high[hash >> 54];
+	}
+
+	// Every bucket expects 256 keys with a standard deviation of 16, the
+	// bound is more than six of them above.
+	S32 fullest = 0;
+	for (S32 i = 0; i < bucketCount; ++i)
+		fullest = mMax(fullest, mMax(low[i], high[i]));
+
+	printf("Sequential %s keys fill the fullest bucket with %d keys. The expected result was below 360.\n", name, fullest);
+	return fullest < 360 ? 0 : 1;
+}
+
+/// Hashes a million distinct keys and counts the collisions of the full
+/// hash, and of its low 32 bits against what a random function would give.
+static S32 testCollisions()
+{
+	const S32 keyCount = 1 << 20;
+	U64 *hashes = static_cast<U64*>(malloc(sizeof(U64) * keyCount));
+	U64 *low = static_cast<U64*>(malloc(sizeof(U64) * keyCount));
+	for (S32 i = 0; i < keyCount; ++i)
+	{
+		// Keys that only differ in a couple of bytes in the middle.
+		char key[48];
+		const S32 length = snprintf(key, sizeof(key), "tenant/%08d/session", i);
+		hashes[i] = hashBytes(key, static_cast<size_t>(length));
+		low[i] = static_cast<U32>(hashes[i]);
+	}
+
+	qsort(hashes, keyCount, sizeof(U64), compareU64);
+	qsort(low, keyCount, sizeof(U64), compareU64);
+	S32 fullCollisions = 0;
+	S32 lowCollisions = 0;
+	for (S32 i = 1; i < keyCount; ++i)
+	{
+		fullCollisions += hashes[i] == hashes[i - 1] ? 1 : 0;
+		lowCollisions += low[i] == low[i - 1] ? 1 : 0;
+	}
+	free(hashes);
+	free(low);
+
+	// n^2 / 2^33 collisions are expected from 32 random bits.
+	printf("%d full and %d 32 bit collisions. The expected result was 0 and about 128.\n", fullCollisions, lowCollisions);
+	return fullCollisions == 0 && lowCollisions < 256 ? 0 : 1;
+}
+
+/// Every length of an all zero buffer, and every seed, has to give a
+/// different hash.
+static S32 testLengthsAndSeeds()
+{
+	U8 zeros[256];
+	memset(zeros, 0, sizeof(zeros));
+
+	U64 hashes[257 + 64];
+	for (S32 i = 0; i <= 256; ++i)
+		hashes[i] = hashBytes(zeros, static_cast<size_t>(i));
+	for (S32 i = 0; i < 64; ++i)
+		hashes[257 + i] = hashBytes(zeros, 16, static_cast<U64>(1) << i);
+
+	const S32 count = static_cast<S32>(sizeof(hashes) / sizeof(hashes[0]));
+	qsort(hashes, count, sizeof(U64), compareU64);
+	S32 duplicates = 0;
+	for (S32 i = 1; i < count; ++i)
+		duplicates += hashes[i] == hashes[i - 1] ? 1 : 0;
+
+	printf("Lengths and seeds gave %d duplicate hashes. The expected result was 0.\n", duplicates);
+	return duplicates;
+}
+
+struct RouteKey
+{
+	U32 tenant;
+	U16 shard;
+	U64 id;
+
+	bool operator==(const RouteKey &other) const
+	{
+		return tenant == other.tenant && shard == other.shard && id == other.id;
+	}
+};
+
+template<>
+class HashFunction<RouteKey>
+{
+public:
+	size_t operator()(const RouteKey &ref) const
+	{
+		return hashValues(ref.tenant, ref.shard, ref.id);
+	}
+};
+
+/// Strided integer keys have to spread over the low and the high bits of
+/// the hash alike, which the identity hash never did.
+static S32 testStridedIntegers()
+{
+	const S32 bucketCount = 1024;
+	S32 low[bucketCount];
+	S32 high[bucketCount];
+	memset(low, 0, sizeof(low));
+	memset(high, 0, sizeof(high));
+
+	HashFunction<S32> hash;
+	for (S32 i = 0; i < 1 << 18; ++i)
+	{
+		const U64 keyHash = static_cast<U64>(hash(i * 4096));
+		++low[keyHash & (bucketCount - 1)];
+		++high[(keyHash >> (sizeof(size_t) * 8 - 10)) & (bucketCount - 1)];
+	}
+
+	S32 fullest = 0;
+	for (S32 i = 0; i < bucketCount; ++i)
+		fullest = mMax(fullest, mMax(low[i], high[i]));
+
+	printf("Strided integer keys fill the fullest bucket with %d keys. The expected result was below 360.\n", fullest);
+	return fullest < 360 ? 0 : 1;
+}
+
+S32 main(S32 argc, const char **argv)
+{
+	S32 failures = 0;
+
+	// A single byte has too few keys to measure avalanche with samples.
+	const size_t lengths[] = { 2, 3, 4, 7, 8, 12, 16, 17, 31, 32, 33, 48, 49, 64 };
+	for (size_t length : lengths)
+		failures += testAvalanche(length);
+
+	failures += testDistribution("integer", false);
+	failures += testDistribution("text", true);
+	failures += testCollisions();
+	failures += testLengthsAndSeeds();
+
+	// Hashing has to look at every byte of a long key, not just at its ends.
+	U8 buffer[200];
+	memset(buffer, 'x', sizeof(buffer));
+	const U64 before = hashBytes(buffer, sizeof(buffer));
+	buffer[100] = 'y';
+	if (hashBytes(buffer, sizeof(buffer)) == before)
+		++failures;
+
+	// A String and a view of the same characters hash the same.
+	HashFunction<String> stringHasher;
+	String text("a String that is long enough to live on the heap");
+	if (stringHasher(text) != stringHasher(StringView(text.c_str(), text.length())))
+		++failures;
+
+	failures += testStridedIntegers();
+
+	// The compile time hash has to agree with hashBytes for every length
+	// and every path through it.
+	static_assert("GET"_hashed.textHash() == compileTimeHash("GET", 3), "Literals have to hash at compile time.");
+	char characters[200];
+	for (S32 i = 0; i < 200; ++i)
+		characters[i] = static_cast<char>(' ' + (i * 37) % 95);
+	S32 compileTimeFailures = 0;
+	for (size_t length = 0; length <= sizeof(characters); ++length)
+	{
+		if (compileTimeHash(characters, length) != hashBytes(characters, length))
+			++compileTimeFailures;
+	}
+
+	// Text hashes of literals can be switched on.
+	const char *methods[] = { "GET", "POST", "DELETE", "PATCH" };
+	S32 matched = 0;
+	for (const char *method : methods)
+	{
+		switch (stringHash(method))
+		{
+		case "GET"_hashed.textHash():
+		case "POST"_hashed.textHash():
+		case "DELETE"_hashed.textHash():
+			++matched;
+			break;
+		default:
+			break;
+		}
+	}
+	if (matched != 3)
+		++compileTimeFailures;
+
+	constexpr HashedKey hashedKey("content-length");
+	if (stringHasher(hashedKey) != stringHasher(String("content-length")))
+		++compileTimeFailures;
+	printf("Compile time hashing failures: %d. The expected result was 0.\n", compileTimeFailures);
+	failures += compileTimeFailures;
+
+	// Floats hash by their bits, -0.0 the same as 0.0.
+	HashFunction<F32> floatHash;
+	HashFunction<F64> doubleHash;
+	S32 floatFailures = 0;
+	if (floatHash(1.1f) == floatHash(1.9f) || doubleHash(1.1) == doubleHash(1.9))
+		++floatFailures;
+	if (floatHash(-0.0f) != floatHash(0.0f) || doubleHash(-0.0) != doubleHash(0.0))
+		++floatFailures;
+	printf("Float hashing failures: %d. The expected result was 0.\n", floatFailures);
+	failures += floatFailures;
+
+	// Combining depends on the order of the values.
+	S32 combineFailures = 0;
+	if (hashValues(1, 2) == hashValues(2, 1) || hashValues(1, 2, 3) == hashValues(1, 2))
+		++combineFailures;
+	if (Hash(makePair(7, String("seven"))) != hashValues(7, String("seven")))
+		++combineFailures;
+	if (hashCombine(hashCombine(0, 5), 6) == hashCombine(hashCombine(0, 6), 5))
+		++combineFailures;
+
+	// Composite keys, with values that only differ in one field.
+	Dictionary<Triple<U32, U16, U64>, S32> byTriple;
+	Dictionary<RouteKey, S32> byRoute;
+	for (U32 tenant = 0; tenant < 16; ++tenant)
+	{
+		for (U16 shard = 0; shard < 16; ++shard)
+		{
+			for (U64 id = 0; id < 16; ++id)
+			{
+				byTriple.insert(makeTriple(tenant, shard, id), static_cast<S32>(tenant * 256 + shard * 16 + id));
+				byRoute.insert(RouteKey{tenant, shard, id}, static_cast<S32>(tenant * 256 + shard * 16 + id));
+			}
+		}
+	}
+	if (byTriple.count() != 4096 || byRoute.count() != 4096)
+		++combineFailures;
+	if (byTriple.find(makeTriple(3U, static_cast<U16>(4), static_cast<U64>(5)))->value != 3 * 256 + 4 * 16 + 5)
+		++combineFailures;
+	if (byRoute.find(RouteKey{15, 15, 15})->value != 4095 || byRoute.contains(RouteKey{16, 0, 0}))
+		++combineFailures;
+	printf("Combined hashing failures: %d. The expected result was 0.\n", combineFailures);
+	failures += combineFailures;
+
+	// A String caches the hash of its characters, which has to follow every
+	// change of them.
+	S32 cacheFailures = 0;
+	auto cacheMatches = [](String &value) -> bool
+	{
+		// The changeable call caches the hash, the const call reads it back.
+		const U64 cachedHash = value.textHash();
+		const String &constValue = value;
+		return cachedHash == stringHash(StringView(value)) && constValue.textHash() == cachedHash;
+	};
+	String fifteen = "fifteen chars!!";
+	String cached = "a string that is long enough to live on the heap";
+	if (!cacheMatches(fifteen) || fifteen[14] != '!' || !cacheMatches(cached))
+		++cacheFailures;
+	cached += " and grows";
+	if (!cacheMatches(cached) || strcmp(cached.c_str(), "a string that is long enough to live on the heap and grows") != 0)
+		++cacheFailures;
+	String copied = cached;
+	cached += "!";
+	if (!cacheMatches(copied) || !cacheMatches(cached) || copied.textHash() == cached.textHash())
+		++cacheFailures;
+	cached = fifteen;
+	copied = move_cast(cached);
+	if (!cacheMatches(cached) || cached.length() != 0 || !cacheMatches(copied) || copied.textHash() != fifteen.textHash())
+		++cacheFailures;
+	fifteen += "+";
+	fifteen.reserve(100);
+	if (!cacheMatches(fifteen) || strcmp(fifteen.c_str(), "fifteen chars!!+") != 0)
+		++cacheFailures;
+	fifteen += fifteen;
+	if (!cacheMatches(fifteen) || fifteen.length() != 32)
+		++cacheFailures;
+
+	if (stringHasher(fifteen) != stringHasher(StringView(fifteen)) || HashedKey(fifteen).textHash() != fifteen.textHash())
+		++cacheFailures;
+	Dictionary<String, S32> byName;
+	byName.insert(fifteen, 1);
+	byName[copied] = 2;
+	if (byName.find(fifteen)->value != 1 || !byName.contains(copied) || byName["fifteen chars!!"] != 2)
+		++cacheFailures;
+	printf("Cached hashing failures: %d. The expected result was 0.\n", cacheFailures);
+	failures += cacheFailures;
+
+	if (failures != 0)
+		printf("There were %d failures. This is a failure!\n", failures);
+
+#ifdef _WIN32
+   system("pause");
+#endif
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include "jbl/lib.hpp"
+#include "jbl/openDictionary.hpp"
+
+S32 main(S32 argc, const char **argv)
+{
+	OpenDictionary<String, S32> kv;
+
+	kv.insert("hello", 2);
+	kv.insert("world", 4);
+	kv.insert("pq", 66);
+
+	printf("First dictionary contents:\n");
+	printf(" kv: %s, %d\n", "hello", kv["hello"]);
+	printf(" kv: %s, %d\n", "world", kv["world"]);
+	printf(" kv: %s, %d\n", "pq", kv["pq"]);
+
+	if (kv.insert("hello", 100))
+		printf("Inserting hello twice should fail. This is a failure!\n");
+
+	auto position = kv.find("world");
+	if (position != kv.end())
+	{
+		printf("erasing world.\n");
+		kv.erase(position);
+	}
+
+	for (const auto &kvPair : kv)
+		printf(" kv: %s, %d\n", kvPair.key.c_str(), kvPair.value);
+
+	// Enough keys to grow the table a bunch of times.
+	OpenDictionary<S32, S32> kvInts;
+	for (S32 i = 0; i < 10000; ++i)
+		kvInts.insert(i, i * 2);
+	printf("kvInts has %d elements in %d slots.\n", kvInts.count(), kvInts.capacity());
+
+	S32 failures = 0;
+	for (S32 i = 0; i < 10000; ++i)
+	{
+		auto it = kvInts.find(i);
+		if (!(it != kvInts.end()) || (*it).value != i * 2)
+			++failures;
+	}
+	if (kvInts.find(10000) != kvInts.end())
+		++failures;
+	printf("Lookup failures: %d. The expected result was 0.\n", failures);
+
+	// Erase every odd key while iterating.
+	auto iter = kvInts.begin();
+	while (iter != kvInts.end())
+	{
+		if ((*iter).key & 1)
+			iter = kvInts.erase(iter);
+		else
+			++iter;
+	}
+
+	S32 remaining = 0;
+	for (const auto &vals : kvInts)
+	{
+		if (vals.key & 1)
+			++failures;
+		++remaining;
+	}
+	printf("kvInts has %d elements left. The expected result was 5000.\n", remaining);
+
+	// Churn through the tombstones left behind by the erases.
+	for (S32 i = 0; i < 100000; ++i)
+	{
+		kvInts[20000 + i] = i;
+		kvInts.erase(kvInts.find(20000 + i));
+	}
+	printf("After churn kvInts has %d elements in %d slots.\n", kvInts.count(), kvInts.capacity());
+
+	if (remaining != 5000 || kvInts.count() != 5000)
+		++failures;
+
+	if (failures != 0)
+		printf("There were %d failures. This is a failure!\n", failures);
+
+#ifdef _WIN32
+   system("pause");
+#endif
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include "jbl/lib.hpp"
+#include "jbl/string.hpp"
+#include "jbl/orderedDictionary.hpp"
+
+S32 main(S32 argc, const char **argv)
+{
+	S32 failures = 0;
+
+	OrderedDictionary<String, S32> kv;
+	kv.insert("world", 4);
+	kv.insert("hello", 2);
+	kv["pq"] = 66;
+	kv["abc"] = 7;
+	if (kv.insert("hello", 100).inserted)
+		++failures;
+
+	printf("First dictionary contents, in insertion order:\n");
+	for (auto &kvPair : kv)
+		printf(" kv: %s, %d\n", kvPair.key.c_str(), kvPair.value);
+
+	const char buffer[] = "hello world";
+	printf("Lookup by view: hello %s, hell %s. The expected result was found, missing.\n",
+		kv.contains(StringView(buffer, 5)) ? "found" : "missing",
+		kv.contains(StringView(buffer, 4)) ? "found" : "missing");
+
+	// Erasing keeps the order of the rest, and a key that comes back goes to
+	// the end. Assigning does not move a key.
+	kv.erase(kv.find("hello"));
+	kv.insertOrAssign("world", 5);
+	kv.insert("hello", 3);
+	const char *expected[] = { "world", "pq", "abc", "hello" };
+	S32 position = 0;
+	for (auto &kvPair : kv)
+	{
+		if (position >= 4 || strcmp(kvPair.key.c_str(), expected[position]) != 0)
+			++failures;
+		++position;
+	}
+	printf("kv has %d elements, world is %d. The expected result was 4, 5.\n", kv.count(), kv["world"]);
+	if (position != 4 || kv.count() != 4 || kv["world"] != 5)
+		++failures;
+
+	// Enough keys to go through every slot width, with every other key
+	// erased along the way so that growing has holes to squeeze out.
+	OrderedDictionary<S32, S32> kvInts;
+	S32 lastSlotBytes = kvInts.indexSlotBytes();
+	for (S32 i = 0; i < 100000; ++i)
+	{
+		kvInts.insert(i, i * 3);
+		if ((i & 1) != 0)
+			kvInts.erase(kvInts.find(i - 1));
+
+		if (kvInts.indexSlotBytes() != lastSlotBytes)
+		{
+			printf("Index slots became %d bytes wide at a capacity of %d.\n", kvInts.indexSlotBytes(), kvInts.capacity());
+			lastSlotBytes = kvInts.indexSlotBytes();
+		}
+	}
+	printf("kvInts has %d elements with %d byte index slots. The expected result was 50000, 4.\n",
+		kvInts.count(), kvInts.indexSlotBytes());
+	if (kvInts.count() != 50000 || kvInts.indexSlotBytes() != 4)
+		++failures;
+
+	S32 previous = -1;
+	S32 seen = 0;
+	for (auto &kvPair : kvInts)
+	{
+		if ((kvPair.key & 1) == 0 || kvPair.key <= previous || kvPair.value != kvPair.key * 3)
+			++failures;
+		previous = kvPair.key;
+		++seen;
+	}
+	if (seen != 50000)
+		++failures;
+
+	for (S32 i = 0; i < 100000; ++i)
+	{
+		if (kvInts.contains(i) != ((i & 1) != 0))
+			++failures;
+	}
+
+	// Erasing while iterating.
+	for (auto it = kvInts.begin(); it != kvInts.end(); )
+	{
+		if (it->key % 4 == 1)
+			it = kvInts.erase(it);
+		else
+			++it;
+	}
+	printf("kvInts has %d elements after erasing while iterating. The expected result was 25000.\n", kvInts.count());
+	if (kvInts.count() != 25000 || kvInts.contains(1) || !kvInts.contains(3))
+		++failures;
+
+	const OrderedDictionary<S32, S32> &constInts = kvInts;
+	if (constInts.find(3) == constInts.end() || constInts.begin()->key != 3)
+		++failures;
+
+	OrderedDictionary<S32, S32> moved(static_cast<OrderedDictionary<S32, S32>&&>(kvInts));
+	moved.clear();
+	moved.insert(9, 9);
+	if (moved.count() != 1 || kvInts.count() != 0 || kvInts.contains(9))
+		++failures;
+
+	if (failures != 0)
+		printf("There were %d failures. This is a failure!\n", failures);
+
+#ifdef _WIN32
+   system("pause");
+#endif
+	return failures == 0 ? 0 : 1;
+}
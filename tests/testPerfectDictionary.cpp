@@ -0,0 +1,149 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+
+#include <stdio.h>
+#include "jbl/lib.hpp"
+#include "jbl/string.hpp"
+#include "jbl/perfectDictionary.hpp"
+
+/// Builds a table and hands it out by value, which takes a move.
+static PerfectDictionary<S32, S32> buildSquares(S32 count)
+{
+	Vector<PerfectDictionary<S32, S32>::KVPair> pairs;
+	for (S32 i = 0; i < count; ++i)
+	{
+		PerfectDictionary<S32, S32>::KVPair pair;
+		pair.key = i;
+		pair.value = i * i;
+		pairs.add(pair);
+	}
+
+	PerfectDictionary<S32, S32> squares;
+	squares.build(pairs);
+	return squares;
+}
+
+S32 main(S32 argc, const char **argv)
+{
+	S32 failures = 0;
+
+	const char *keywords[] = {
+		"alignas", "alignof", "auto", "bool", "break", "case", "catch", "char", "class", "const",
+		"constexpr", "continue", "decltype", "default", "delete", "do", "double", "else", "enum",
+		"explicit", "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int",
+		"long", "mutable", "namespace", "new", "noexcept", "nullptr", "operator", "private",
+		"protected", "public", "return", "short", "signed", "sizeof", "static", "struct", "switch",
+		"template", "this", "throw", "true", "try", "typedef", "typename", "union", "unsigned",
+		"using", "virtual", "void", "volatile", "while"
+	};
+	const S32 keywordCount = static_cast<S32>(sizeof(keywords) / sizeof(keywords[0]));
+
+	// Vector only holds plain data, so String pairs go into an array.
+	PerfectDictionary<String, S32>::KVPair pairs[keywordCount + 1];
+	for (S32 i = 0; i < keywordCount; ++i)
+	{
+		pairs[i].key = keywords[i];
+		pairs[i].value = i;
+	}
+
+	// A duplicate, the first pair has to win.
+	pairs[keywordCount].key = "while";
+	pairs[keywordCount].value = -1;
+
+	PerfectDictionary<String, S32> kv;
+	const bool built = kv.build(pairs, keywordCount + 1);
+	printf("Built %s with %d elements in %d buckets. The expected result was yes with %d elements.\n",
+		built ? "yes" : "no", kv.count(), kv.bucketCount(), keywordCount);
+	if (!built || kv.count() != keywordCount)
+		++failures;
+
+	for (S32 i = 0; i < keywordCount; ++i)
+	{
+		auto position = kv.find(keywords[i]);
+		if (position == kv.end() || position->value != i)
+			++failures;
+	}
+	if (kv.contains("register") || kv.contains("whil") || kv.contains(""))
+		++failures;
+
+	const char buffer[] = "voidness";
+	printf("Lookup by view: void %s, voi %s. The expected result was found, missing.\n",
+		kv.contains(StringView(buffer, 4)) ? "found" : "missing",
+		kv.contains(StringView(buffer, 3)) ? "found" : "missing");
+
+	// Every slot holds exactly one key.
+	S32 iterated = 0;
+	for (auto &pair : kv)
+	{
+		if (kv.find(pair.key) == kv.end())
+			++failures;
+		++iterated;
+	}
+	if (iterated != keywordCount)
+		++failures;
+
+	// A large set, with keys that the identity hash of S32 gives in order.
+	Vector<PerfectDictionary<S32, S32>::KVPair> intPairs;
+	for (S32 i = 0; i < 200000; ++i)
+	{
+		PerfectDictionary<S32, S32>::KVPair pair;
+		pair.key = i * 3;
+		pair.value = i;
+		intPairs.add(pair);
+	}
+
+	PerfectDictionary<S32, S32> kvInts;
+	kvInts.build(intPairs);
+	S32 intFailures = 0;
+	for (S32 i = 0; i < 200000; ++i)
+	{
+		auto position = kvInts.find(i * 3);
+		if (position == kvInts.end() || position->value != i || kvInts.contains(i * 3 + 1))
+			++intFailures;
+	}
+	printf("kvInts has %d elements, failures: %d. The expected result was 200000, 0.\n", kvInts.count(), intFailures);
+	failures += intFailures;
+
+	// Moving takes the arrays and leaves the source empty.
+	PerfectDictionary<S32, S32> squares = buildSquares(100);
+	S32 moveFailures = 0;
+	if (squares.count() != 100 || squares.find(9)->value != 81)
+		++moveFailures;
+	squares = move_cast(kvInts);
+	if (squares.count() != 200000 || squares.find(300)->value != 100 || kvInts.count() != 0 || kvInts.contains(300) || kvInts.begin() != kvInts.end())
+		++moveFailures;
+	printf("Moved PerfectDictionary failures: %d. The expected result was 0.\n", moveFailures);
+	failures += moveFailures;
+
+	const PerfectDictionary<S32, S32> empty;
+	if (empty.contains(0) || empty.begin() != empty.end())
+		++failures;
+
+	if (failures != 0)
+		printf("There were %d failures. This is a failure!\n", failures);
+
+#ifdef _WIN32
+   system("pause");
+#endif
+	return failures == 0 ? 0 : 1;
+}
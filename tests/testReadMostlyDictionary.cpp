@@ -0,0 +1,121 @@
+//-----------------------------------------------------------------------------
+// Copyright (c) 2016-2017 Jeff Hutchinson
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include "jbl/types.hpp"
+#include "jbl/thread.hpp"
+#include "jbl/readMostlyDictionary.hpp"
+
+typedef ReadMostlyDictionary<S32, S32> Routes;
+
+static const S32 sReaderCount = 4;
+static const S32 sKeyCount = 100;
+static const S32 sGenerations = 200;
+
+Routes routes;
+Atomic<U32> writerDone;
+Atomic<U32> failures;
+
+void reader(void *)
+{
+	Routes::Reader routesReader(&routes);
+	while (writerDone.load() == 0)
+	{
+		// Every key must always be there.
+		for (S32 i = 0; i < sKeyCount; ++i)
+		{
+			S32 value;
+			if (!routesReader.find(i, value))
+				failures.fetchAdd(1);
+		}
+
+		// A single version never mixes two generations.
+		routesReader.read([](const Routes::Table &table) {
+			S32 generation = table.find(0)->value;
+			for (auto &pair : table)
+			{
+				if (pair.value != generation)
+					failures.fetchAdd(1);
+			}
+		});
+	}
+}
+
+void writer(void *)
+{
+	for (S32 generation = 1; generation <= sGenerations; ++generation)
+	{
+		routes.update([generation](Routes::Table &table) {
+			for (auto &pair : table)
+				pair.value = generation;
+		});
+	}
+	writerDone.store(1);
+}
+
+S32 main(S32 argc, const char **argv)
+{
+	for (S32 i = 0; i < sKeyCount; ++i)
+		routes.insert(i, 0);
+
+	Thread *readers[sReaderCount];
+	for (S32 i = 0; i < sReaderCount; ++i)
+		readers[i] = new Thread(reader, nullptr);
+	Thread *writerThread = new Thread(writer, nullptr);
+
+	writerThread->join();
+	delete writerThread;
+	for (S32 i = 0; i < sReaderCount; ++i)
+	{
+		readers[i]->join();
+		delete readers[i];
+	}
+
+	Routes::Reader mainReader(&routes);
+	S32 value = -1;
+	mainReader.find(42, value);
+	printf("Route 42 is %d. The expected result was %d.\n", value, sGenerations);
+	if (value != sGenerations)
+		failures.fetchAdd(1);
+
+	// Writes that do not change anything must not publish a version.
+	if (routes.insert(42, 0) || routes.erase(sKeyCount))
+		failures.fetchAdd(1);
+
+	routes.erase(42);
+	routes.insertOrAssign(43, -1);
+	printf("routes has %d elements, 42 is %s, 43 is %d. The expected result was %d, missing, -1.\n",
+		routes.count(), mainReader.contains(42) ? "found" : "missing", (mainReader.find(43, value), value), sKeyCount - 1);
+
+	routes.reclaim();
+	printf("%d retired versions are left. The expected result was 0.\n", routes.retiredCount());
+	if (routes.retiredCount() != 0)
+		failures.fetchAdd(1);
+
+	if (failures.load() != 0)
+		printf("There were %u failures. This is a failure!\n", failures.load());
+
+#ifdef _WIN32
+   system("pause");
+#endif
+	return failures.load() == 0 ? 0 : 1;
+}